@@ -3,6 +3,9 @@
 */
 
 #include "aivoice_interface.h"
+#include "aivoice_event_queue.h"
+#include "aivoice_memory.h"
+#include "aivoice_reblock.h"
 #include <stddef.h>
 #include <stdio.h>
 #include <string.h>
@@ -18,8 +21,25 @@
 #define AIVOICE_ENABLE_AFE_SSL      (1)
 #endif
 
+/* 1: events are queued inside feed and drained by rtk_aivoice_poll_events,
+   0: events are handled in the callback, inside feed */
+#define AIVOICE_ENABLE_EVENT_QUEUE  (0)
+
+/* 1: print heap usage of the flow and its modules before create */
+#define AIVOICE_SHOW_MEMORY_REPORT  (0)
+
+/* 1: measure process time of the test audio fed with 8/16/32 ms frames before the example runs */
+#define AIVOICE_BENCHMARK_FRAME_SIZES   (0)
+
+/* 1: measure process time of AFE+KWS with 5/20/50 keywords before the example runs,
+   keywords are split into KWS nodes of MAX_KWS_KEYWORD_NUMS keywords */
+#define AIVOICE_BENCHMARK_KEYWORDS      (0)
+
 #if AIVOICE_ENABLE_AFE_SSL
-#include "cJSON/cJSON.h"
+#include "aivoice_event_decode.h"
+#endif
+#if AIVOICE_BENCHMARK_KEYWORDS
+#include "aivoice_graph.h"
 #endif
 /*****************************************************************************/
 //            aivoive binary resource configuration
@@ -30,6 +50,9 @@
 #define AIVOICE_BIN_FLASH_ADDRESS_START (0x08A00000)
 // bytes of aivoice_models.bin
 #define AIVOICE_BIN_SIZE (4*1024*1024)
+/* 1: read models in place from memory mapped (XIP) flash, instead of copying the bin to heap */
+#define AIVOICE_BIN_EXECUTE_IN_PLACE (0)
+#include "aivoice_resource.h"
 #endif
 /*****************************************************************************/
 //               DSP optimization configuration
@@ -56,6 +79,15 @@ extern unsigned int get_test_wav_len(void);
 __attribute__((weak))
 const char *aivoice_load_resource_from_flash(void)
 {
+#if AIVOICE_BIN_EXECUTE_IN_PLACE
+	/* only the header is checked here, model pages are read by the flow when used */
+	struct aivoice_resource *res = rtk_aivoice_resource_map((const void *)AIVOICE_BIN_FLASH_ADDRESS_START, 0);
+	if (!res) {
+		printf("map aivoice resource failed\n");
+		return NULL;
+	}
+	return rtk_aivoice_resource_data(res);
+#else
 	char *aivoice_resources = (char *)malloc(AIVOICE_BIN_SIZE);
 	if (!aivoice_resources) {
 		printf("malloc failed for aivoice resource buffer\n");
@@ -65,31 +97,151 @@ const char *aivoice_load_resource_from_flash(void)
 	printf("load aivoice resource from flash to memory\n");
 	memcpy(aivoice_resources, (const void *)AIVOICE_BIN_FLASH_ADDRESS_START, AIVOICE_BIN_SIZE);
 	return aivoice_resources;
+#endif
 }
 #endif
 
 #if AIVOICE_ENABLE_AFE_SSL
 static void aivoice_show_afe_ssl_message(struct aivoice_evout_afe *afe_out)
 {
-	if (afe_out->out_others_json) {
-		char *json = afe_out->out_others_json;
-
-		cJSON *root_obj = cJSON_Parse((char *)json);
-		if (root_obj != NULL) {
-			cJSON *ssl_angle_obj = cJSON_GetObjectItem(root_obj, "ssl_angle");
-			if (ssl_angle_obj) {
-				float angle = ssl_angle_obj->valuedouble;
-				if (angle >= 0) {
-					printf("[user] voice angle %.1f\n", angle);
-				}
-			}
+	/* decode out_others_json in place, without json parser and memory allocation */
+	struct aivoice_evout_afe_info afe_info;
+	rtk_aivoice_decode_afe_info(afe_out->out_others_json, -1, &afe_info);
+	if (afe_info.flags & AIVOICE_AFE_FLAG_SSL_ANGLE) {
+		printf("[user] voice angle %.1f\n", afe_info.ssl_angle);
+	}
+}
+#endif
+
+#if AIVOICE_SHOW_MEMORY_REPORT
+static void aivoice_show_memory_report(const struct rtk_aivoice_iface *aivoice, struct aivoice_config *config)
+{
+	static const char *const module_names[AIVOICE_MEMORY_MODULE_NUM] = {"afe", "vad", "kws", "asr"};
+	struct aivoice_memory_report report;
+
+	if (rtk_aivoice_query_memory(aivoice, config, &report) != 0) {
+		printf("[user] query memory failed\n");
+		return;
+	}
 
-			cJSON_Delete(root_obj);
+	printf("[user] memory(bytes)  persistent  scratch  peak  sram_persistent  sram_peak\n");
+	printf("[user] flow           %u  %u  %u  %u  %u\n",
+		   report.total[AIVOICE_MEMORY_REGION_DEFAULT].persistent,
+		   report.total[AIVOICE_MEMORY_REGION_DEFAULT].scratch,
+		   report.total[AIVOICE_MEMORY_REGION_DEFAULT].peak,
+		   report.total[AIVOICE_MEMORY_REGION_SRAM].persistent,
+		   report.total[AIVOICE_MEMORY_REGION_SRAM].peak);
+	for (int m = 0; m < AIVOICE_MEMORY_MODULE_NUM; m++) {
+		if (report.module_mask & (1 << m)) {
+			printf("[user]   %s          %u  %u  %u  %u  %u\n", module_names[m],
+				   report.modules[m][AIVOICE_MEMORY_REGION_DEFAULT].persistent,
+				   report.modules[m][AIVOICE_MEMORY_REGION_DEFAULT].scratch,
+				   report.modules[m][AIVOICE_MEMORY_REGION_DEFAULT].peak,
+				   report.modules[m][AIVOICE_MEMORY_REGION_SRAM].persistent,
+				   report.modules[m][AIVOICE_MEMORY_REGION_SRAM].peak);
 		}
 	}
 }
 #endif
 
+#if AIVOICE_BENCHMARK_FRAME_SIZES || AIVOICE_BENCHMARK_KEYWORDS
+static int aivoice_callback_silent(void *userdata, enum aivoice_out_event_type event_type,
+								   const void *msg, int len)
+{
+	(void)userdata;
+	(void)event_type;
+	(void)msg;
+	(void)len;
+	return 0;
+}
+#endif
+
+#if AIVOICE_BENCHMARK_FRAME_SIZES
+static void aivoice_benchmark_frame_sizes(const struct rtk_aivoice_iface *aivoice, struct aivoice_config *config)
+{
+	static const int frame_sizes[] = {128, 256, 512};
+	int channels = MIC_NUM + config->afe->ref_num;
+	const char *audio = (const char *)get_test_wav() + 44;
+	int len = (int)get_test_wav_len() - 44;
+
+	for (unsigned int i = 0; i < sizeof(frame_sizes) / sizeof(frame_sizes[0]); i++) {
+		int frame_bytes = channels * frame_sizes[i] * (int)sizeof(short);
+		void *handle = aivoice->create(config);
+		if (!handle) {
+			return;
+		}
+		rtk_aivoice_register_callback(handle, aivoice_callback_silent, NULL);
+		struct aivoice_reblock *reblock = rtk_aivoice_reblock_create(aivoice, handle, channels, frame_sizes[i]);
+		if (!reblock) {
+			aivoice->destroy(handle);
+			return;
+		}
+
+		for (int offset = 0; offset <= len - frame_bytes; offset += frame_bytes) {
+			rtk_aivoice_reblock_feed(reblock, (char *)audio + offset, frame_bytes);
+		}
+
+		// process time per second of audio, multiply by cpu frequency in MHz to get cycles
+		struct aivoice_reblock_stats stats;
+		rtk_aivoice_reblock_get_stats(reblock, &stats);
+		long long audio_ms = (long long)stats.blocks * config->afe->frame_size * 1000 / config->afe->sample_rate;
+		printf("[user] frame %d samples: %u frames, %lld us per second of audio\n", frame_sizes[i],
+			   stats.frames, audio_ms > 0 ? stats.process_us * 1000 / audio_ms : 0);
+
+		rtk_aivoice_reblock_destroy(reblock);
+		aivoice->destroy(handle);
+	}
+}
+#endif
+
+#if AIVOICE_BENCHMARK_KEYWORDS
+static void aivoice_benchmark_keywords(struct aivoice_config *config)
+{
+	static const int keyword_nums[] = {5, 20, 50};
+	static const char *keywords[50];
+	struct aivoice_pipeline_config pipeline_config = AIVOICE_PIPELINE_CONFIG_DEFAULT();
+	int channels = MIC_NUM + config->afe->ref_num;
+	int frame_bytes = channels * config->afe->frame_size * (int)sizeof(short);
+	const char *audio = (const char *)get_test_wav() + 44;
+	int len = (int)get_test_wav_len() - 44;
+
+	// cost does not depend on the keyword text, repeat the keywords of the linked kws model
+	for (int i = 0; i < 50; i++) {
+		keywords[i] = (i & 1) ? "ni-hao-xiao-qiang" : "xiao-qiang-xiao-qiang";
+	}
+	// kws runs inside feed
+	pipeline_config.threaded = 0;
+
+	for (unsigned int i = 0; i < sizeof(keyword_nums) / sizeof(keyword_nums[0]); i++) {
+		struct aivoice_graph *graph = rtk_aivoice_graph_create();
+		if (!graph) {
+			return;
+		}
+		rtk_aivoice_graph_add_node(graph, AIVOICE_NODE_AFE, config);
+		int kws_num = rtk_aivoice_graph_add_keywords(graph, config, keywords, NULL, keyword_nums[i], NULL, 0);
+		struct aivoice_pipeline *pipeline = kws_num > 0 ? rtk_aivoice_graph_compile(graph, &pipeline_config) : NULL;
+		rtk_aivoice_graph_destroy(graph);
+		if (!pipeline) {
+			return;
+		}
+		rtk_aivoice_pipeline_register_callback(pipeline, aivoice_callback_silent, NULL);
+
+		for (int offset = 0; offset <= len - frame_bytes; offset += frame_bytes) {
+			rtk_aivoice_pipeline_feed(pipeline, (char *)audio + offset, frame_bytes);
+		}
+
+		// process time per second of audio, multiply by cpu frequency in MHz to get cycles
+		struct aivoice_pipeline_stats stats;
+		rtk_aivoice_pipeline_get_stats(pipeline, &stats);
+		long long audio_ms = (long long)stats.fed_frames * config->afe->frame_size * 1000 / config->afe->sample_rate;
+		printf("[user] %d keywords, %d kws nodes: %lld us per second of audio\n", keyword_nums[i], kws_num,
+			   audio_ms > 0 ? stats.feed_us * 1000 / audio_ms : 0);
+
+		rtk_aivoice_pipeline_destroy(pipeline);
+	}
+}
+#endif
+
 static int aivoice_callback_process(void *userdata,
 									enum aivoice_out_event_type event_type,
 									const void *msg, int len)
@@ -227,6 +379,18 @@ void aivoice_algo_offline_example(void)
 	config.common = &aivoice_param; // can be NULL
 #endif
 
+#if AIVOICE_SHOW_MEMORY_REPORT
+	aivoice_show_memory_report(aivoice, &config);
+#endif
+
+#if AIVOICE_BENCHMARK_FRAME_SIZES
+	aivoice_benchmark_frame_sizes(aivoice, &config);
+#endif
+
+#if AIVOICE_BENCHMARK_KEYWORDS
+	aivoice_benchmark_keywords(&config);
+#endif
+
 	/* step 3:
 	 * Create the aivoice instance.
 	 */
@@ -240,7 +404,23 @@ void aivoice_algo_offline_example(void)
 	 * You may only receive some of the aivoice_out_event_type in this example,
 	 * depending on the flow you use.
 	 * */
+#if AIVOICE_ENABLE_EVENT_QUEUE
+	/* or let aivoice only queue the events,
+	 * and handle them later out of feed, e.g. in another thread.
+	 * */
+	struct aivoice_event_queue_config queue_param = AIVOICE_EVENT_QUEUE_CONFIG_DEFAULT();
+	queue_param.audio_slot_bytes = afe_param.frame_size * sizeof(short);
+	queue_param.channel_bytes = afe_param.frame_size * sizeof(short);
+	struct aivoice_event_queue *queue = rtk_aivoice_event_queue_create(&queue_param);
+	if (!queue) {
+		aivoice->destroy(handle);
+		return;
+	}
+	rtk_aivoice_register_event_queue(handle, queue);
+	struct aivoice_event events[8];
+#else
 	rtk_aivoice_register_callback(handle, aivoice_callback_process, NULL);
+#endif
 
 	/* when run on chips, we get online audio stream,
 	 * here we use a fix audio.
@@ -262,10 +442,34 @@ void aivoice_algo_offline_example(void)
 			break;
 		}
 
+#if AIVOICE_ENABLE_EVENT_QUEUE
+		int n;
+		while ((n = rtk_aivoice_poll_events(queue, events, 8)) > 0) {
+			for (int i = 0; i < n; i++) {
+				const void *msg = events[i].msg;
+				if (events[i].type == AIVOICE_EVOUT_VAD) {
+					msg = &events[i].u.vad;
+				} else if (events[i].type == AIVOICE_EVOUT_AFE) {
+					msg = &events[i].u.afe;
+				}
+				aivoice_callback_process(NULL, events[i].type, msg, events[i].len);
+			}
+		}
+#endif
+
 		audio_offset += afe_frame_bytes;
 	}
 
 	/* step 6:
 	 * Destroy the aivoice instance */
 	aivoice->destroy(handle);
+
+#if AIVOICE_ENABLE_EVENT_QUEUE
+	struct aivoice_event_queue_stats queue_stats;
+	rtk_aivoice_event_queue_get_stats(queue, &queue_stats);
+	printf("[user] event queue: pushed %u, dropped %u, audio dropped %u, high watermark %u\n",
+		   queue_stats.pushed, queue_stats.dropped_events,
+		   queue_stats.dropped_audio, queue_stats.high_watermark);
+	rtk_aivoice_event_queue_destroy(queue);
+#endif
 }
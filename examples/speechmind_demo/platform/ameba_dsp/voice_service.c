@@ -26,6 +26,7 @@
 #include "voice_utils.h"
 #include "parcel.h"
 #include "aivoice_interface.h"
+#include "aivoice_resource.h"
 
 #define AFE_FRAME_MS 16
 #define AFE_IN_CHANNEL 3
@@ -69,34 +70,57 @@ static uint32_t g_usr_data;
 #define AIVOICE_BIN_FLASH_ADDRESS_START (0x08A00000)
 // bytes of aivoice_models.bin
 #define MAX_AIVOICE_BIN_SIZE (4*1024*1024)
+/* 1: read models in place from memory mapped (XIP) flash, instead of copying the bin to heap */
+#define AIVOICE_BIN_EXECUTE_IN_PLACE (0)
+/* 1: load only the models used by the selected flow, instead of the whole bin */
+#define AIVOICE_BIN_SELECTIVE_LOAD (0)
 #endif
 
 #if USE_BINARY_RESOURCE
+static struct aivoice_resource *g_resource = NULL;
+
 __attribute__((weak))
 const char *aivoice_load_resource_from_flash(void)
 {
-    const uint8_t *flash_header = (const uint8_t *)AIVOICE_BIN_FLASH_ADDRESS_START;
-    uint32_t bin_size = 0;
-
-    bin_size = ((uint32_t)flash_header[15] << 24) |
-               ((uint32_t)flash_header[14] << 16) |
-               ((uint32_t)flash_header[13] << 8)  |
-               ((uint32_t)flash_header[12]);
-
-    if (bin_size == 0 || bin_size > MAX_AIVOICE_BIN_SIZE) { // 限制最大 4MB
-        LOGE("Invalid bin size: %d, max %d\n", bin_size, MAX_AIVOICE_BIN_SIZE);
-        return NULL;
-    }
+	/* the resource is loaded once and shared by every instance created after,
+	   it is released when the last instance is destroyed. */
+	if (g_resource) {
+		rtk_aivoice_resource_retain(g_resource);
+		return rtk_aivoice_resource_data(g_resource);
+	}
 
-    char *aivoice_resources = (char *)malloc(bin_size);
-	if (!aivoice_resources) {
-		LOGE("malloc failed for aivoice resource buffer\n");
+#if AIVOICE_BIN_EXECUTE_IN_PLACE
+	g_resource = rtk_aivoice_resource_map((const void *)AIVOICE_BIN_FLASH_ADDRESS_START, 0);
+#elif AIVOICE_BIN_SELECTIVE_LOAD
+	g_resource = rtk_aivoice_resource_open_models((const void *)AIVOICE_BIN_FLASH_ADDRESS_START,
+				 rtk_aivoice_resource_models_of(g_aivoice, NULL));
+#else
+	g_resource = rtk_aivoice_resource_open((const void *)AIVOICE_BIN_FLASH_ADDRESS_START, 0);
+#endif
+	if (!g_resource) {
+		LOGE("Invalid aivoice resource at 0x%x, max size %d\n",
+			 AIVOICE_BIN_FLASH_ADDRESS_START, MAX_AIVOICE_BIN_SIZE);
 		return NULL;
 	}
 
-	LOGI("Load aivoice resource from flash (size=%d bytes)\n", bin_size);
-	memcpy(aivoice_resources, (const void *)AIVOICE_BIN_FLASH_ADDRESS_START, bin_size);
-	return aivoice_resources;
+	struct aivoice_resource_info info;
+	rtk_aivoice_resource_get_info(g_resource, &info);
+	LOGI("%s aivoice resource from flash (size=%d bytes)\n", info.mapped ? "Map" : "Load", info.size);
+	return info.data;
+}
+
+static void aivoice_release_resource(void)
+{
+	struct aivoice_resource_info info;
+
+	if (!g_resource) {
+		return;
+	}
+	rtk_aivoice_resource_get_info(g_resource, &info);
+	rtk_aivoice_resource_close(g_resource);
+	if (info.refcount == 1) {
+		g_resource = NULL;
+	}
 }
 #endif
 /*****************************************************************************/
@@ -335,6 +359,9 @@ static HRESULT *Voice_Create(VOICE_RPC_INIT *pParam, RPC_STRUCT *pRpcStruct, HRE
 #endif
 	g_handle = g_aivoice->create(&config);
 	if (!g_handle) {
+#if USE_BINARY_RESOURCE
+		aivoice_release_resource();
+#endif
 		*pRes = -1;
 		return pRes;
 	}
@@ -361,6 +388,9 @@ static HRESULT *Voice_destroy(long *pParam, RPC_STRUCT *pRpcStruct, HRESULT *pRe
 	}
 	if (g_handle) {
 		g_aivoice->destroy(g_handle);
+#if USE_BINARY_RESOURCE
+		aivoice_release_resource();
+#endif
 	}
 	g_handle = NULL;
 	return pRes;
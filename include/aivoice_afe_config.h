@@ -75,7 +75,7 @@ typedef struct afe_config {
 	afe_mic_geometry_e  mic_array;          // microphone array. Make sure to choose the matched resource library everytime changed.
 	int ref_num;                            // reference channel number, must be 0 or 1. AEC will be disabled if ref_num=0.
 	int sample_rate;                        // sampling rate(Hz), must be 16000
-	int frame_size;                         // frame length(samples), must be 256
+	int frame_size;                         // frame length(samples), must be 256. other sizes: aivoice_reblock.h
 
 	afe_mode_e afe_mode;                    // AFE mode, for ASR or voice communication.
 	bool enable_aec;                        // AEC(Acoustic Echo Cancellation) module switch
@@ -0,0 +1,99 @@
+#ifndef _AIVOICE_ALLOCATOR_H_
+#define _AIVOICE_ALLOCATOR_H_
+
+#include <stddef.h>
+
+/*
+ * Memory allocation of aivoice utilities (event queue, resource, ...).
+ *
+ * Every allocation carries a memory class hint, so that an allocator can place
+ * hot scratch in DTCM/SRAM, persistent state in PSRAM, and model weights
+ * wherever they are read fastest.
+ *
+ * Arena mode: give each class a pre-allocated buffer with an arena allocator,
+ * then the utilities do not malloc after their objects are created.
+ * Memory of an arena is only released by rtk_aivoice_arena_reset().
+ * Arena allocation is lock-free and can be called from several threads,
+ * e.g. the pipeline worker, lazy ASR and a task swapping models.
+ *
+ * NOTE: the allocator MUST be set before any utility object is created,
+ *       and MUST NOT be changed while any of them is alive.
+ *       The prebuilt aivoice flows (full flow, AFE, VAD, KWS, ASR) do NOT use
+ *       it: they keep their own malloc, placed by
+ *       aivoice_sdk_config.memory_alloc_mode, so arena mode does not make a
+ *       pipeline or flow malloc free.
+ */
+
+typedef enum {
+	AIVOICE_MEMORY_CLASS_SCRATCH = 0,   /* hot scratch, touched every frame */
+	AIVOICE_MEMORY_CLASS_STATE = 1,     /* persistent state */
+	AIVOICE_MEMORY_CLASS_WEIGHTS = 2,   /* model resource, read only after loaded */
+	AIVOICE_MEMORY_CLASS_NUM,
+} aivoice_memory_class_e;
+
+struct aivoice_allocator {
+	void *(*alloc)(void *user_data, size_t size, aivoice_memory_class_e mem_class);
+	void *(*aligned_alloc)(void *user_data, size_t size, size_t alignment, aivoice_memory_class_e mem_class);
+	void (*free)(void *user_data, void *ptr);   /* free memory of both alloc and aligned_alloc */
+	void *user_data;
+};
+
+/* a linear arena on a user buffer, e.g. DTCM, SRAM, or hugepages on Linux */
+struct aivoice_arena {
+	char *base;
+	size_t size;
+	size_t used;
+};
+
+/* an allocator placing each memory class into its own arena.
+   classes without arena fall back to the default heap. */
+struct aivoice_arena_allocator {
+	struct aivoice_arena *arenas[AIVOICE_MEMORY_CLASS_NUM];
+};
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Set the allocator of aivoice utilities.
+ *
+ * @param[in] allocator   allocator, which is copied; NULL to restore the default heap allocator.
+ */
+void rtk_aivoice_set_allocator(const struct aivoice_allocator *allocator);
+
+/**
+ * @brief Allocate, align and free memory with the current allocator.
+ *        Memory returned by rtk_aivoice_mem_alloc is at least 8 bytes aligned.
+ */
+void *rtk_aivoice_mem_alloc(size_t size, aivoice_memory_class_e mem_class);
+void *rtk_aivoice_mem_calloc(size_t size, aivoice_memory_class_e mem_class);
+void *rtk_aivoice_mem_aligned_alloc(size_t size, size_t alignment, aivoice_memory_class_e mem_class);
+void rtk_aivoice_mem_free(void *ptr);
+
+/**
+ * @brief Initialize an arena on a user buffer.
+ */
+void rtk_aivoice_arena_init(struct aivoice_arena *arena, void *buffer, size_t size);
+
+/**
+ * @brief Release everything allocated from the arena at once.
+ *        Only call it when nothing allocated from the arena is in use, and no thread allocates from it.
+ */
+void rtk_aivoice_arena_reset(struct aivoice_arena *arena);
+
+/**
+ * @brief Fill an allocator that places memory classes into the arenas of arena_allocator.
+ *        arena_allocator MUST stay alive while the allocator is used.
+ *
+ * @param[in]  arena_allocator   arenas for each memory class, NULL entries use the default heap.
+ * @param[out] allocator         allocator to pass to rtk_aivoice_set_allocator.
+ */
+void rtk_aivoice_arena_allocator(struct aivoice_arena_allocator *arena_allocator,
+								 struct aivoice_allocator *allocator);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // _AIVOICE_ALLOCATOR_H_
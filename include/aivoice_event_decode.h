@@ -0,0 +1,86 @@
+#ifndef _AIVOICE_EVENT_DECODE_H_
+#define _AIVOICE_EVENT_DECODE_H_
+
+#include "aivoice_interface.h"
+
+/*
+ * Typed payloads of the json events.
+ *
+ * AIVOICE_EVOUT_WAKEUP, AIVOICE_EVOUT_ASR_RESULT, AIVOICE_EVOUT_AGE_GENDER_RESULT
+ * and aivoice_evout_afe->out_others_json are json strings.
+ * The decoders below convert them into fixed-size structures
+ * without memory allocation, so clients do not need a json library.
+ * The messages carry no timing, use aivoice_lookback.h for the audio of an event.
+ */
+
+#define AIVOICE_ASR_MAX_COMMANDS (4)
+
+/* flags of aivoice_evout_afe_info */
+#define AIVOICE_AFE_FLAG_ABNORMAL   (1 << 0)    /* abnormal_flag is set */
+#define AIVOICE_AFE_FLAG_SSL_ANGLE  (1 << 1)    /* ssl_angle is valid */
+
+struct aivoice_evout_wakeup {
+	int id;                         /* keyword id, start from 1 */
+	float score;                    /* wakeup score */
+};
+
+struct aivoice_evout_asr {
+	int type;
+	float conf;                     /* confidence */
+	int num_commands;
+	int command_ids[AIVOICE_ASR_MAX_COMMANDS];
+};
+
+typedef enum {
+	AIVOICE_AGE_GENDER_UNKNOWN = -1,
+	AIVOICE_AGE_GENDER_CHILD = 0,
+	AIVOICE_AGE_GENDER_ADULT_FEMALE = 1,
+	AIVOICE_AGE_GENDER_ADULT_MALE = 2,
+} aivoice_age_gender_e;
+
+struct aivoice_evout_age_gender {
+	aivoice_age_gender_e result;
+};
+
+struct aivoice_evout_afe_info {
+	unsigned int flags;             /* AIVOICE_AFE_FLAG_xxx */
+	float ssl_angle;                /* degree, valid when AIVOICE_AFE_FLAG_SSL_ANGLE is set */
+};
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Decode the json message of AIVOICE_EVOUT_WAKEUP.
+ *
+ * @param[in]  json    json message
+ * @param[in]  len     bytes of json, or -1 when json is '\0' terminated
+ * @param[out] out     decoded result
+ *
+ * @retval  0: success;  others: json is not a valid wakeup message.
+ */
+int rtk_aivoice_decode_wakeup(const char *json, int len, struct aivoice_evout_wakeup *out);
+
+/**
+ * @brief Decode the json message of AIVOICE_EVOUT_ASR_RESULT.
+ *        Only the first AIVOICE_ASR_MAX_COMMANDS command ids are kept.
+ */
+int rtk_aivoice_decode_asr(const char *json, int len, struct aivoice_evout_asr *out);
+
+/**
+ * @brief Decode the json message of AIVOICE_EVOUT_AGE_GENDER_RESULT.
+ */
+int rtk_aivoice_decode_age_gender(const char *json, int len, struct aivoice_evout_age_gender *out);
+
+/**
+ * @brief Decode aivoice_evout_afe->out_others_json.
+ *        flags is 0 when json is NULL or empty.
+ */
+int rtk_aivoice_decode_afe_info(const char *json, int len, struct aivoice_evout_afe_info *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // _AIVOICE_EVENT_DECODE_H_
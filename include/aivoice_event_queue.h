@@ -0,0 +1,177 @@
+#ifndef _AIVOICE_EVENT_QUEUE_H_
+#define _AIVOICE_EVENT_QUEUE_H_
+
+#include "aivoice_interface.h"
+#include "aivoice_event_decode.h"
+#include "aivoice_timing.h"
+#include "aivoice_lookback.h"
+
+/*
+ * Pull-based event delivery.
+ *
+ * By default aivoice delivers every result through aivoice_callback_handler,
+ * synchronously from inside feed(). When an event queue is registered instead,
+ * the callback only stores the event into a fixed-capacity lock-free queue,
+ * and another thread drains it with rtk_aivoice_poll_events().
+ *
+ * The queue is single-producer (the thread calling feed) and
+ * single-consumer (the thread calling rtk_aivoice_poll_events).
+ * No memory is allocated after rtk_aivoice_event_queue_create().
+ */
+
+#define AIVOICE_EVENT_MSG_MAX_LEN (256)  /* bytes kept for json messages, including '\0' */
+
+/* payloads kept for json events, can be combined */
+#define AIVOICE_EVENT_PAYLOAD_JSON  (1 << 0)    /* keep the json string in aivoice_event.msg, for debug */
+#define AIVOICE_EVENT_PAYLOAD_TYPED (1 << 1)    /* decode json into the typed structures of aivoice_event.u,
+                                                   in rtk_aivoice_poll_events, not in feed */
+
+struct aivoice_event_queue_config {
+	int capacity;           /* max number of queued events, MUST be power of 2 */
+	int audio_slots;        /* max number of queued AFE audio frames, MUST be power of 2.
+                               set to 0 to drop AFE audio and only keep out_others_json */
+	int audio_slot_bytes;   /* bytes of one AFE audio frame,
+                               ch_num * afe_config.frame_size * sizeof(short) */
+	int channel_bytes;      /* bytes of one channel of an AFE audio frame, afe_config.frame_size * sizeof(short).
+                               0 when audio_slot_bytes holds one channel */
+	int payload;            /* AIVOICE_EVENT_PAYLOAD_xxx */
+};
+
+struct aivoice_event {
+	enum aivoice_out_event_type type;
+	int len;                            /* len of the original callback message */
+	int audio_slot;                     /* audio slot held by AIVOICE_EVOUT_AFE, -1 if none */
+	union {
+		struct aivoice_evout_vad vad;   /* AIVOICE_EVOUT_VAD */
+		struct aivoice_evout_afe afe;   /* AIVOICE_EVOUT_AFE, afe.data points to the audio slot,
+                                           afe.out_others_json points to msg below */
+		struct aivoice_evout_wakeup wakeup;         /* AIVOICE_EVOUT_WAKEUP, typed payload */
+		struct aivoice_evout_asr asr;               /* AIVOICE_EVOUT_ASR_RESULT, typed payload */
+		struct aivoice_evout_age_gender age_gender; /* AIVOICE_EVOUT_AGE_GENDER_RESULT, typed payload */
+	} u;
+	struct aivoice_evout_afe_info afe_info;         /* AIVOICE_EVOUT_AFE, typed payload */
+	struct aivoice_event_stamp stamp;   /* set when queued by rtk_aivoice_event_queue_stamped_handler,
+                                           otherwise capture_us is 0 */
+	struct aivoice_audio_segment segment;   /* audio of VAD/WAKEUP/ASR_RESULT when a lookback
+                                               is attached, samples are 0 otherwise */
+	char msg[AIVOICE_EVENT_MSG_MAX_LEN];/* json of WAKEUP/ASR_RESULT/AGE_GENDER_RESULT,
+                                           and out_others_json of AFE.
+                                           empty if AIVOICE_EVENT_PAYLOAD_JSON is not set.
+                                           typed payloads are decoded from it, so they
+                                           only see the first AIVOICE_EVENT_MSG_MAX_LEN - 1 bytes */
+};
+
+struct aivoice_event_queue_stats {
+	unsigned int pushed;                /* events stored into the queue */
+	unsigned int polled;                /* events handed out by rtk_aivoice_poll_events */
+	unsigned int dropped_events;        /* events dropped because the queue was full */
+	unsigned int dropped_audio;         /* AFE frames whose audio was dropped because no slot was free,
+                                           or cut to audio_slot_bytes, with ch_num of the whole channels kept */
+	unsigned int truncated_msgs;        /* json messages longer than AIVOICE_EVENT_MSG_MAX_LEN */
+	unsigned int decode_errors;         /* json messages failed to decode into typed payloads */
+	unsigned int high_watermark;        /* max number of events queued at the same time */
+};
+
+struct aivoice_event_queue;
+
+#define AIVOICE_EVENT_QUEUE_CONFIG_DEFAULT() {\
+    .capacity=32,\
+    .audio_slots=8,\
+    .audio_slot_bytes=256*sizeof(short),\
+    .channel_bytes=256*sizeof(short),\
+    .payload=AIVOICE_EVENT_PAYLOAD_JSON,\
+};
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Create an event queue.
+ *
+ * @param[in] config    queue configuration, NULL to use AIVOICE_EVENT_QUEUE_CONFIG_DEFAULT.
+ *
+ * @retval    queue, or NULL to indicate an error.
+ */
+struct aivoice_event_queue *rtk_aivoice_event_queue_create(const struct aivoice_event_queue_config *config);
+
+/**
+ * @brief Destroy the event queue.
+ *        Unregister it (or destroy the aivoice instance) first.
+ */
+void rtk_aivoice_event_queue_destroy(struct aivoice_event_queue *queue);
+
+/**
+ * @brief Drop every queued event and reset the stats.
+ *        Only call it when neither feed nor poll is running.
+ */
+void rtk_aivoice_event_queue_reset(struct aivoice_event_queue *queue);
+
+/**
+ * @brief The aivoice_callback_handler that pushes events into the queue.
+ *        user_data MUST be the queue.
+ *        It can be called from a user callback to queue only part of the events.
+ */
+int rtk_aivoice_event_queue_handler(void *user_data,
+									enum aivoice_out_event_type event_type,
+									const void *msg, int len);
+
+/**
+ * @brief The aivoice_stamped_callback_handler that pushes events with stamps into the queue.
+ *        Register it with rtk_aivoice_timing_register_callback, user_data MUST be the queue.
+ */
+int rtk_aivoice_event_queue_stamped_handler(void *user_data,
+		enum aivoice_out_event_type event_type,
+		const void *msg, int len,
+		const struct aivoice_event_stamp *stamp);
+
+/**
+ * @brief Deliver the events of an aivoice instance into the queue
+ *        instead of calling a user callback.
+ *        Same as rtk_aivoice_register_callback(handle, rtk_aivoice_event_queue_handler, queue).
+ *
+ * @param[in] handle    aivoice instance
+ * @param[in] queue     event queue
+ */
+void rtk_aivoice_register_event_queue(void *handle, struct aivoice_event_queue *queue);
+
+/**
+ * @brief Attach a lookback ring. AFE audio is kept in it, and VAD, WAKEUP and
+ *        ASR_RESULT events are queued with their audio segment.
+ *        Check rtk_aivoice_lookback_segment_valid after reading a segment.
+ *        Only call it when feed is not running.
+ *
+ * @param[in] queue     event queue
+ * @param[in] lookback  lookback ring, NULL to detach
+ */
+void rtk_aivoice_event_queue_attach_lookback(struct aivoice_event_queue *queue,
+		struct aivoice_lookback *lookback);
+
+/**
+ * @brief Drain events from the queue, in the order they were produced.
+ *
+ *        AFE audio is not copied again: events[i].u.afe.data references
+ *        an audio slot of the queue, which stays valid until the next call of
+ *        rtk_aivoice_poll_events() on the same queue.
+ *        Typed payloads are decoded here, so feed only pays for a copy of the json.
+ *
+ * @param[in]  queue     event queue
+ * @param[out] events    array to receive events
+ * @param[in]  max       number of elements in events
+ *
+ * @retval  number of events returned, 0 when the queue is empty.
+ */
+int rtk_aivoice_poll_events(struct aivoice_event_queue *queue,
+							struct aivoice_event *events, int max);
+
+/**
+ * @brief Get counters of the queue, including overflow counters.
+ */
+void rtk_aivoice_event_queue_get_stats(struct aivoice_event_queue *queue,
+									   struct aivoice_event_queue_stats *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // _AIVOICE_EVENT_QUEUE_H_
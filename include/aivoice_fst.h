@@ -0,0 +1,77 @@
+#ifndef _AIVOICE_FST_H_
+#define _AIVOICE_FST_H_
+
+/*
+ * ASR command FST compiler.
+ *
+ * ASR recognizes the commands of its FST model, e.g. fst_cn_cmd_ac40 with
+ * about 40 air conditioner commands. Compile builds such a model from a
+ * list of commands, on the device at runtime or on a host at build time,
+ * so a new command set does not need an offline rebuild:
+ *     static const struct aivoice_fst_command commands[] = {
+ *         {"da kai kong tiao", "打开空调"},
+ *         {"guan bi kong tiao", "关闭空调"},
+ *     };
+ *     size = rtk_aivoice_fst_compile(commands, 2, units, num_units, NULL, 0);
+ *     fst = malloc(size);
+ *     rtk_aivoice_fst_compile(commands, 2, units, num_units, fst, size);
+ *     res = rtk_aivoice_resource_open_replace(flash_addr, AIVOICE_MODEL_FST, fst, size, "fst_user");
+ * and create ASR with rtk_aivoice_resource_data(res), or switch a running
+ * pipeline to it with rtk_aivoice_pipeline_swap_model.
+ *
+ * The graph is deterministic and minimal: commands sharing a prefix share
+ * its states, so a state has at most one arc per unit and search does not
+ * branch on common prefixes, and common suffixes, e.g. "... feng liang",
+ * are merged. The command id is output on the first arc where the prefix
+ * leads to that command only. A command that is a prefix of another one
+ * ends with an arc of unit 0.
+ */
+
+#define AIVOICE_FST_MAX_STATES      (65535)
+#define AIVOICE_FST_MAX_ARCS        (65535)
+
+struct aivoice_fst_command {
+	const char *pinyin;         /* units of the command separated by spaces or '-', e.g. "da kai kong tiao" */
+	const char *text;           /* command text reported in asr results, utf-8 */
+};
+
+struct aivoice_fst_info {
+	int num_commands;
+	int num_states;
+	int num_arcs;
+	int num_units;              /* units of the ASR model the FST was compiled for */
+};
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Compile commands into an ASR command FST, the format of fst_cn_cmd_ac40.bin.
+ *
+ * @param[in]  commands     commands, command id i+1 is commands[i]
+ * @param[in]  num          number of commands
+ * @param[in]  units        output units of the ASR model, units[i] is the pinyin of unit id i,
+ *                          toneless, e.g. "zhong". unit 0 is reserved.
+ * @param[in]  num_units    number of units, e.g. 402 of asr_cn models
+ * @param[out] out          FST, NULL to get the size only
+ * @param[in]  out_size     bytes of out
+ *
+ * @retval  bytes of the FST, or -1 when a unit is unknown, two commands have the same pinyin,
+ *          out is too small or the graph exceeds AIVOICE_FST_MAX_STATES / AIVOICE_FST_MAX_ARCS.
+ */
+int rtk_aivoice_fst_compile(const struct aivoice_fst_command *commands, int num,
+							const char *const *units, int num_units, void *out, unsigned int out_size);
+
+/**
+ * @brief Get the size of an FST, e.g. one compiled by rtk_aivoice_fst_compile.
+ *
+ * @retval  0: success;  -1: fst is not a valid FST.
+ */
+int rtk_aivoice_fst_get_info(const void *fst, struct aivoice_fst_info *info);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // _AIVOICE_FST_H_
@@ -0,0 +1,155 @@
+#ifndef _AIVOICE_GRAPH_H_
+#define _AIVOICE_GRAPH_H_
+
+#include "aivoice_interface.h"
+#include "aivoice_pipeline.h"
+
+/*
+ * Flow graph builder.
+ *
+ * Compose module nodes into flows not offered by the fixed ifaces, e.g.
+ * AFE+VAD+ASR without KWS, VAD-gated KWS, or AFE feeding two KWS models.
+ *
+ *     graph = rtk_aivoice_graph_create();
+ *     afe = rtk_aivoice_graph_add_node(graph, AIVOICE_NODE_AFE, &config);
+ *     vad = rtk_aivoice_graph_add_node(graph, AIVOICE_NODE_VAD, &config);
+ *     kws = rtk_aivoice_graph_add_node(graph, AIVOICE_NODE_KWS, &config);
+ *     rtk_aivoice_graph_connect(graph, afe, vad, AIVOICE_EDGE_AUDIO);
+ *     rtk_aivoice_graph_connect(graph, afe, kws, AIVOICE_EDGE_AUDIO);
+ *     rtk_aivoice_graph_connect(graph, vad, kws, AIVOICE_EDGE_SPEECH_GATE);
+ *     pipeline = rtk_aivoice_graph_compile(graph, &pipeline_config);
+ *     rtk_aivoice_graph_destroy(graph);
+ *
+ * Compile checks the graph, orders the nodes so that gates run before the
+ * nodes they control, creates only the modules in the graph, and
+ * preallocates the buffers between stages. The result is a pipeline,
+ * used with the rtk_aivoice_pipeline_xxx api.
+ *
+ * Without AFE node, nodes are fed with 16 ms mono frames directly.
+ *
+ * Several KWS models, e.g. Chinese and English keywords of a bilingual
+ * product, run on one AFE: add a KWS node per model, each with its own
+ * kws_config, and a resource holding its KWS model (see
+ * rtk_aivoice_resource_open_names), all fed by the AFE node.
+ * Register a callback per KWS node to tell which model woke up:
+ *     kws_cn = rtk_aivoice_graph_add_node(graph, AIVOICE_NODE_KWS, &config_cn);
+ *     kws_en = rtk_aivoice_graph_add_node(graph, AIVOICE_NODE_KWS, &config_en);
+ *     ...
+ *     rtk_aivoice_pipeline_register_node_callback(pipeline, kws_cn, cb, &model_cn);
+ *     rtk_aivoice_pipeline_register_node_callback(pipeline, kws_en, cb, &model_en);
+ * Each KWS instance extracts its own features, the prebuilt modules do not
+ * take features as input.
+ *
+ * A KWS model detects at most MAX_KWS_KEYWORD_NUMS keywords per instance.
+ * Longer keyword lists, e.g. of a user-defined keyword model, are split into
+ * shards by rtk_aivoice_graph_add_keywords, one KWS node per shard on the
+ * same AFE output. Keyword id n of shard i is
+ * keywords[i * MAX_KWS_KEYWORD_NUMS + n - 1]:
+ *     num = rtk_aivoice_graph_add_keywords(graph, &config, keywords, NULL, 20, kws, 4);
+ *     ...
+ *     for (i = 0; i < num; i++)
+ *         rtk_aivoice_pipeline_register_node_callback(pipeline, kws[i], cb, &shard[i]);
+ * Cost grows with the number of shards, connect one ENERGY or VAD node to
+ * all of them as speech gate to keep idle cost low.
+ */
+
+#define AIVOICE_GRAPH_MAX_NODES     (16)
+
+typedef enum {
+	AIVOICE_NODE_AFE = 0,       /* aivoice_iface_afe_v1, at most one */
+	AIVOICE_NODE_VAD = 1,       /* aivoice_iface_vad_v1 */
+	AIVOICE_NODE_KWS = 2,       /* aivoice_iface_kws_v1 */
+	AIVOICE_NODE_ASR = 3,       /* aivoice_iface_asr_v1 */
+	AIVOICE_NODE_ENERGY = 4,    /* energy detector on an adaptive noise floor, no model.
+                                   a cheap speech gate, see gate_xxx of aivoice_pipeline_config */
+	AIVOICE_NODE_TYPE_NUM,
+} aivoice_node_type_e;
+
+typedef enum {
+	AIVOICE_EDGE_AUDIO = 0,         /* AFE -> node: node is fed with channel 0 of AFE output */
+	AIVOICE_EDGE_WAKEUP_GATE = 1,   /* KWS -> node: node only runs within aivoice_sdk_config.timeout
+                                       after a keyword, ASR results extend the session.
+                                       KWS pauses during the session. */
+	AIVOICE_EDGE_SPEECH_GATE = 2,   /* VAD or ENERGY -> node: node only runs while speech is detected.
+                                       when it opens, node is first fed with up to
+                                       gate_preroll_ms of the frames it skipped */
+} aivoice_edge_type_e;
+
+struct aivoice_graph;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Create an empty graph.
+ */
+struct aivoice_graph *rtk_aivoice_graph_create(void);
+
+/**
+ * @brief Destroy the graph. Pipelines compiled from it are not affected.
+ */
+void rtk_aivoice_graph_destroy(struct aivoice_graph *graph);
+
+/**
+ * @brief Add a module node.
+ *
+ * @param[in] graph     graph
+ * @param[in] type      module of the node
+ * @param[in] config    configuration to create the module, nodes of the same type
+ *                      can use different configurations, e.g. two kws_config.
+ *                      it MUST stay valid until the compiled pipeline is destroyed.
+ *                      NULL for AIVOICE_NODE_ENERGY.
+ *
+ * @retval  node id (>= 0), or -1 to indicate an error.
+ */
+int rtk_aivoice_graph_add_node(struct aivoice_graph *graph, aivoice_node_type_e type,
+							   struct aivoice_config *config);
+
+/**
+ * @brief Add KWS nodes for a keyword list of any length, MAX_KWS_KEYWORD_NUMS keywords per node.
+ *        The nodes are connected to the AFE node if the graph has one.
+ *
+ * @param[in]  graph        graph
+ * @param[in]  config       configuration of the KWS nodes, sensitivity, mode and enable_age_gender
+ *                          are taken from config->kws (KWS_CONFIG_DEFAULT if NULL).
+ *                          it is copied, keywords and thresholds are set per node.
+ * @param[in]  keywords     keywords, available keywords depend on kws model.
+ *                          the strings MUST stay valid until the compiled pipeline is destroyed.
+ * @param[in]  thresholds   threshold of each keyword, NULL to use sensitivity for all
+ * @param[in]  num_keywords number of keywords
+ * @param[out] nodes        node id of each shard, node nodes[i] detects keywords from
+ *                          i * MAX_KWS_KEYWORD_NUMS. can be NULL
+ * @param[in]  max_nodes    size of nodes
+ *
+ * @retval  number of KWS nodes added, or -1 to indicate an error, then no node is added.
+ */
+int rtk_aivoice_graph_add_keywords(struct aivoice_graph *graph, const struct aivoice_config *config,
+								   const char *const *keywords, const float *thresholds, int num_keywords,
+								   int *nodes, int max_nodes);
+
+/**
+ * @brief Connect output of node src to node dst.
+ *        A node has at most one edge of each type as input.
+ *
+ * @retval  0: success;  -1: invalid edge.
+ */
+int rtk_aivoice_graph_connect(struct aivoice_graph *graph, int src, int dst, aivoice_edge_type_e edge);
+
+/**
+ * @brief Compile the graph into a pipeline.
+ *        pipeline_config->stages is not used, the nodes are given by the graph.
+ *
+ * @param[in] graph             graph
+ * @param[in] pipeline_config   pipeline configuration, NULL to use AIVOICE_PIPELINE_CONFIG_DEFAULT.
+ *
+ * @retval  pipeline, or NULL when the graph is invalid or a module can not be created.
+ */
+struct aivoice_pipeline *rtk_aivoice_graph_compile(struct aivoice_graph *graph,
+		const struct aivoice_pipeline_config *pipeline_config);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // _AIVOICE_GRAPH_H_
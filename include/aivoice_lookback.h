@@ -0,0 +1,108 @@
+#ifndef _AIVOICE_LOOKBACK_H_
+#define _AIVOICE_LOOKBACK_H_
+
+#include "aivoice_interface.h"
+
+/*
+ * Lookback ring of enhanced AFE audio.
+ *
+ * Keeps the most recent AFE output (channel 0), and hands out the audio
+ * segment of VAD, wakeup and ASR events without copying, e.g. for cloud
+ * handoff or local re-scoring. A segment is given as two spans, since it
+ * may wrap around the end of the ring.
+ *
+ * Pass every event of the instance to rtk_aivoice_lookback_on_event(), in the
+ * callback, or attach the lookback to an event queue.
+ *
+ * Segment ranges, in time relative to the reset point:
+ *   VAD status 1:     [offset_ms, now], offset_ms already includes vad left_margin
+ *   VAD status 0:     [offset_ms of status 1, offset_ms]
+ *   WAKEUP:           [now - keyword_window_ms, now]
+ *   ASR_RESULT:       [now - command_window_ms, now]
+ * where now is the audio in the ring when the event is delivered. Wakeup and
+ * ASR results carry no timing, so their window is sized for the longest
+ * keyword or command; the keyword ends just before the wakeup, and the ASR
+ * result comes after the vad right_margin of the command. Ranges are clipped
+ * to the audio in the ring.
+ *
+ * The ring is written by the thread delivering events. Another thread may
+ * read a segment, then check rtk_aivoice_lookback_segment_valid() to know
+ * it was not overwritten meanwhile: push gives up the oldest samples before
+ * it starts overwriting them.
+ */
+
+struct aivoice_lookback_config {
+	int duration_ms;        /* audio kept in the ring */
+	int keyword_window_ms;  /* audio of wakeup segments, ending at the wakeup */
+	int command_window_ms;  /* audio of ASR segments, ending at the ASR result */
+};
+
+struct aivoice_audio_segment {
+	const short *data[2];   /* spans of 16 kHz mono audio, data[1] is NULL when not wrapped */
+	int samples[2];         /* samples of each span, both 0 for no segment */
+	unsigned long long start_sample;    /* position of the first sample since reset */
+};
+
+struct aivoice_lookback;
+
+#define AIVOICE_LOOKBACK_CONFIG_DEFAULT() {\
+    .duration_ms=4000,\
+    .keyword_window_ms=1500,\
+    .command_window_ms=3000,\
+};
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Create a lookback ring.
+ *
+ * @param[in] config    NULL to use AIVOICE_LOOKBACK_CONFIG_DEFAULT.
+ *
+ * @retval    lookback, or NULL to indicate an error.
+ */
+struct aivoice_lookback *rtk_aivoice_lookback_create(const struct aivoice_lookback_config *config);
+
+void rtk_aivoice_lookback_destroy(struct aivoice_lookback *lookback);
+
+/**
+ * @brief Drop the audio in the ring. Call it when the aivoice instance is reset.
+ */
+void rtk_aivoice_lookback_reset(struct aivoice_lookback *lookback);
+
+/**
+ * @brief Append audio to the ring.
+ */
+void rtk_aivoice_lookback_push(struct aivoice_lookback *lookback, const short *audio, int samples);
+
+/**
+ * @brief Get the segment of audio in [start_ms, end_ms), relative to the reset point.
+ *
+ * @retval  0: success;  -1: no audio of the range in the ring.
+ */
+int rtk_aivoice_lookback_get(struct aivoice_lookback *lookback, unsigned int start_ms, unsigned int end_ms,
+							 struct aivoice_audio_segment *segment);
+
+/**
+ * @brief Handle one event of the aivoice instance, with the arguments of aivoice_callback_handler.
+ *        AFE audio is appended to the ring, and VAD, WAKEUP and ASR_RESULT get their segment.
+ *
+ * @retval  1: segment is set;  0: no segment for this event.
+ */
+int rtk_aivoice_lookback_on_event(struct aivoice_lookback *lookback,
+								  enum aivoice_out_event_type event_type,
+								  const void *msg, int len,
+								  struct aivoice_audio_segment *segment);
+
+/**
+ * @brief Whether the audio of segment is still in the ring.
+ */
+int rtk_aivoice_lookback_segment_valid(struct aivoice_lookback *lookback,
+									   const struct aivoice_audio_segment *segment);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // _AIVOICE_LOOKBACK_H_
@@ -0,0 +1,67 @@
+#ifndef _AIVOICE_MEMORY_H_
+#define _AIVOICE_MEMORY_H_
+
+#include "aivoice_interface.h"
+
+typedef enum {
+	AIVOICE_MEMORY_REGION_DEFAULT = 0,  /* sdk default heap (PSRAM) */
+	AIVOICE_MEMORY_REGION_SRAM = 1,     /* SRAM heap, used by AIVOICE_MEMORY_ALLOC_MODE_SRAM.
+                                           ONLY available on Hifi5DSP platform. */
+	AIVOICE_MEMORY_REGION_NUM,
+} aivoice_memory_region_e;
+
+typedef enum {
+	AIVOICE_MEMORY_MODULE_AFE = 0,
+	AIVOICE_MEMORY_MODULE_VAD = 1,
+	AIVOICE_MEMORY_MODULE_KWS = 2,
+	AIVOICE_MEMORY_MODULE_ASR = 3,
+	AIVOICE_MEMORY_MODULE_NUM,
+} aivoice_memory_module_e;
+
+struct aivoice_memory_usage {
+	unsigned int persistent;    /* bytes held from create until destroy */
+	unsigned int scratch;       /* bytes allocated on top of persistent while feeding */
+	unsigned int peak;          /* max bytes held at the same time, persistent + scratch */
+};
+
+struct aivoice_memory_report {
+	unsigned int module_mask;   /* (1 << aivoice_memory_module_e) of modules used by the flow */
+
+	/* the whole flow, as it will be created */
+	struct aivoice_memory_usage total[AIVOICE_MEMORY_REGION_NUM];
+
+	/* each module alone, created with its single module flow and the same configuration */
+	struct aivoice_memory_usage modules[AIVOICE_MEMORY_MODULE_NUM][AIVOICE_MEMORY_REGION_NUM];
+};
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Query heap usage of a flow for the given configuration.
+ *
+ *        The flow and each of its modules are created, fed with a few frames
+ *        of silence and destroyed, while heap usage is sampled.
+ *        persistent is measured on the platform it runs on, for the same iface,
+ *        config and resource. scratch and peak only cover the paths silence
+ *        runs: memory taken on speech, after a wakeup or while ASR decodes is
+ *        not seen, so keep a margin over them. Call it when no other task
+ *        allocates memory, and when there is enough heap for one instance.
+ *
+ * @param[in]  iface     aivoice flow, e.g. &aivoice_iface_full_flow_v1
+ * @param[in]  config    configuration which will be used to create the flow,
+ *                       config->afe can be NULL for flows without AFE (vad_v1, kws_v1, asr_v1)
+ * @param[out] report    memory report
+ *
+ * @retval  0: success;  others: the flow or one of its modules can not be created.
+ */
+int rtk_aivoice_query_memory(const struct rtk_aivoice_iface *iface,
+							 struct aivoice_config *config,
+							 struct aivoice_memory_report *report);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // _AIVOICE_MEMORY_H_
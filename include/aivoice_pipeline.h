@@ -0,0 +1,346 @@
+#ifndef _AIVOICE_PIPELINE_H_
+#define _AIVOICE_PIPELINE_H_
+
+#include "aivoice_interface.h"
+
+/*
+ * Composite flow built from single module flows.
+ *
+ * AFE runs in feed (aivoice_iface_afe_v1), and its output is fed to the
+ * recognition stages (aivoice_iface_vad_v1, aivoice_iface_kws_v1,
+ * aivoice_iface_asr_v1), with the same behavior as the full flow:
+ * ASR and VAD only run within aivoice_sdk_config.timeout after a keyword
+ * is detected, and AIVOICE_EVOUT_ASR_REC_TIMEOUT is sent when ASR exits.
+ * Without KWS stage, ASR and VAD always run. VAD is reset at each wakeup,
+ * its offset_ms is still relative to the pipeline reset point, like the AFE
+ * audio, so lookback segments of VAD events are right.
+ * Other combinations of modules can be built with aivoice_graph.h.
+ *
+ * Threaded mode decouples AFE from recognition with a lock-free
+ * single-producer single-consumer frame queue, so they can run on
+ * different cores. Recognition runs in rtk_aivoice_pipeline_process(),
+ * called in a loop by a thread created by the user, which chooses its core,
+ * priority and stack. All events, AFE included, are delivered from that
+ * thread in frame order.
+ *
+ * Backpressure is bounded: when the queue is full, feed waits at most
+ * feed_timeout_ms, then drops the frame for recognition.
+ *
+ * Lazy ASR: ASR is created when a keyword is detected and destroyed
+ * asr_linger_ms after the session ends, so it takes no memory while idle.
+ * The first frame after wakeup waits for ASR create, in threaded mode the
+ * frame queue absorbs it and no audio is lost. Quick re-wakes within the
+ * linger time reuse the ASR instance.
+ *
+ * Gated KWS: KWS inference only runs while a cheap pre-detector detects
+ * speech, to cut idle CPU. The pre-detector is an energy detector, or VAD
+ * (then VAD runs all the time and its events are sent outside sessions too).
+ * A short history of frames is fed to KWS when the gate opens, so keyword
+ * onsets are not clipped.
+ *
+ * Quality adaption: the average cost of feed (AFE, and recognition when not
+ * threaded) is monitored against the 16 ms frame period. When it stays over
+ * budget_high_percent, AFE steps down the ladder of aivoice_quality_level_e
+ * to cheaper settings, and steps back up when it stays under
+ * budget_low_percent for a longer time. The configuration of the prebuilt
+ * AFE can not change in place, so each step needs a new AFE instance. Feed
+ * only requests the step; the new instance is built off the feed thread by
+ * rtk_aivoice_pipeline_adapt_quality, which the worker calls in threaded
+ * mode, while the old instance keeps running. It is switched in between two
+ * frames: the recognition stages keep their state, but AEC and NS converge
+ * again from scratch, for about a second, at every step. When the build
+ * fails the old instance and level are kept. Each transition is reported to
+ * the quality callback.
+ *
+ * Configuration update: rtk_aivoice_pipeline_update_config changes module
+ * configs (e.g. KWS thresholds, VAD margins, ASR sensitivity) or the session
+ * timeout while audio keeps flowing. New module instances are created in the
+ * calling thread, then switched in between two frames by the thread running
+ * the node, so feed and recognition are not interrupted. A new instance
+ * starts without the audio context of the old one. The prebuilt AFE has no
+ * setters, so any AFE change, even agc_fixed_gain alone, is a new AFE whose
+ * AEC and NS converge again from scratch, for about a second; only nodes
+ * whose module config really changes get a new instance.
+ *
+ * Model swap: rtk_aivoice_pipeline_swap_model switches VAD/KWS/ASR nodes
+ * to models of another resource, e.g. another KWS variant loaded with
+ * rtk_aivoice_resource_open_names on a background task. AFE keeps running
+ * and keeps its converged AEC/NS state. The pipeline holds a reference of
+ * the resource, and closes the resource of the old model once the new one
+ * is switched in.
+ *
+ * Staged start: AFE comes up first, the other modules are created when
+ * their models arrive. Create the pipeline with staged_start and a resource
+ * holding the AFE models only, which are small and load fast, then load the
+ * rest on a background task and hand it over:
+ *     config.resource = rtk_aivoice_resource_data(
+ *             rtk_aivoice_resource_open_models(flash, AIVOICE_MODEL_MASK(AIVOICE_MODEL_AFE)));
+ *     pipeline = rtk_aivoice_pipeline_create(&config, &pipeline_config);
+ *     // feed runs, AFE events are sent
+ *     ...
+ *     // background task
+ *     res = rtk_aivoice_resource_open_models(flash, mask of the other models);
+ *     rtk_aivoice_pipeline_load_models(pipeline, rtk_aivoice_resource_data(res));
+ * The modules are switched in between two frames, and are first fed the
+ * last load_preroll_ms of AFE output, so an early keyword is not lost.
+ *
+ * NOTE: KWS and ASR run on channel 0 of AFE output. When AFE outputs
+ *       multiple channels, the multi-channel KWS of the full flow is not reproduced.
+ */
+
+#define AIVOICE_PIPELINE_STAGE_VAD  (1 << 0)
+#define AIVOICE_PIPELINE_STAGE_KWS  (1 << 1)
+#define AIVOICE_PIPELINE_STAGE_ASR  (1 << 2)
+
+typedef enum {
+	AIVOICE_PIPELINE_GATE_NONE = 0,     /* KWS runs on every frame */
+	AIVOICE_PIPELINE_GATE_ENERGY = 1,   /* KWS runs while frame energy is above the noise floor */
+	AIVOICE_PIPELINE_GATE_VAD = 2,      /* KWS runs while VAD detects speech */
+} aivoice_pipeline_gate_e;
+
+typedef enum {
+	AIVOICE_QUALITY_FULL = 0,       /* afe_config as given */
+	AIVOICE_QUALITY_AEC_MID = 1,    /* aec_cost at most AFE_AEC_FILTER_MID */
+	AIVOICE_QUALITY_AEC_LOW = 2,    /* aec_cost AFE_AEC_FILTER_LOW */
+	AIVOICE_QUALITY_NS_LOW = 3,     /* and ns_cost_mode AFE_NS_COST_LOW */
+	AIVOICE_QUALITY_SSL_OFF = 4,    /* and SSL disabled */
+	AIVOICE_QUALITY_LEVEL_NUM,
+} aivoice_quality_level_e;
+
+struct aivoice_quality_event {
+	aivoice_quality_level_e from;
+	aivoice_quality_level_e to;
+	unsigned int cost_percent;      /* average feed cost, percent of the frame period */
+	const struct afe_config *afe;   /* AFE configuration used from now on */
+};
+
+/**
+ * @brief Callback of quality transitions, called in feed when the AFE of the new level is switched in.
+ */
+typedef void (*aivoice_quality_callback)(void *user_data, const struct aivoice_quality_event *event);
+
+struct aivoice_pipeline_config {
+	int stages;             /* AIVOICE_PIPELINE_STAGE_xxx running on AFE output */
+	int threaded;           /* 0: recognition runs in feed.
+                               1: recognition runs in rtk_aivoice_pipeline_process */
+	int queue_frames;       /* frames queued between AFE and recognition, MUST be power of 2.
+                               one frame is 16 ms */
+	int feed_timeout_ms;    /* max time feed waits for a free frame when the queue is full,
+                               then the frame is dropped. set to -1 to wait forever */
+	int asr_lazy;           /* 1: create ASR on wakeup and destroy it when the session ends.
+                               only works with KWS stage */
+	int asr_linger_ms;      /* lazy ASR: time ASR is kept after the session ends */
+	aivoice_pipeline_gate_e kws_gate;   /* gate of KWS, in rtk_aivoice_pipeline_create */
+	int gate_threshold_db;  /* energy gate opens when frame energy exceeds the noise floor by this */
+	int gate_hangover_ms;   /* energy gate stays open this long after energy drops */
+	int gate_preroll_ms;    /* frames fed to a gated node when its gate opens */
+	int quality_adapt;      /* 1: step AFE quality down and up with the feed cost. needs AFE */
+	int budget_high_percent;/* step down when the average cost stays above this */
+	int budget_low_percent; /* step up when the average cost stays below this */
+	int budget_down_ms;     /* time above budget_high_percent before a step down */
+	int budget_up_ms;       /* time below budget_low_percent before a step up */
+	int staged_start;       /* 1: only AFE is created, the other modules wait for
+                               rtk_aivoice_pipeline_load_models */
+	int load_preroll_ms;    /* staged start: AFE output kept for the modules until they are loaded */
+};
+
+struct aivoice_pipeline_stats {
+	unsigned int fed_frames;            /* frames output by AFE */
+	unsigned int processed_frames;      /* frames processed by recognition stages */
+	unsigned int dropped_frames;        /* frames dropped because the queue was full */
+	unsigned int high_watermark;        /* max number of frames queued at the same time */
+	unsigned int asr_creates;           /* lazy ASR: times ASR was created */
+	unsigned int asr_create_us_max;     /* lazy ASR: max time of ASR create */
+	unsigned int gated_frames;          /* frames seen by speech gated nodes */
+	unsigned int skipped_frames;        /* frames speech gated nodes skipped, preroll excluded */
+	unsigned int skipped_percent;       /* skipped_frames * 100 / gated_frames */
+	unsigned int cost_percent;          /* average feed cost, percent of the frame period */
+	unsigned int quality_level;         /* aivoice_quality_level_e in use */
+	unsigned int quality_changes;       /* quality transitions */
+	unsigned int load_frames;           /* staged start: frames output by AFE before the models were loaded */
+	long long feed_us;                  /* time spent in feed of AFE, recognition stages included when not threaded */
+};
+
+struct aivoice_pipeline;
+struct aivoice_resource;
+
+#define AIVOICE_PIPELINE_CONFIG_DEFAULT() {\
+    .stages=AIVOICE_PIPELINE_STAGE_KWS | AIVOICE_PIPELINE_STAGE_ASR,\
+    .threaded=1,\
+    .queue_frames=16,\
+    .feed_timeout_ms=32,\
+    .asr_lazy=0,\
+    .asr_linger_ms=2000,\
+    .kws_gate=AIVOICE_PIPELINE_GATE_NONE,\
+    .gate_threshold_db=9,\
+    .gate_hangover_ms=320,\
+    .gate_preroll_ms=320,\
+    .quality_adapt=0,\
+    .budget_high_percent=80,\
+    .budget_low_percent=50,\
+    .budget_down_ms=160,\
+    .budget_up_ms=3000,\
+    .staged_start=0,\
+    .load_preroll_ms=1000,\
+};
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Create a pipeline.
+ *
+ * @param[in] config            aivoice configuration, same as create of aivoice flows.
+ *                              it MUST stay valid until the pipeline is destroyed.
+ * @param[in] pipeline_config   pipeline configuration, NULL to use AIVOICE_PIPELINE_CONFIG_DEFAULT.
+ *
+ * @retval    pipeline, or NULL to indicate an error.
+ */
+struct aivoice_pipeline *rtk_aivoice_pipeline_create(struct aivoice_config *config,
+		const struct aivoice_pipeline_config *pipeline_config);
+
+/**
+ * @brief Destroy the pipeline.
+ *        In threaded mode, call rtk_aivoice_pipeline_stop and wait until
+ *        the worker thread returns from rtk_aivoice_pipeline_process first.
+ */
+void rtk_aivoice_pipeline_destroy(struct aivoice_pipeline *pipeline);
+
+/**
+ * @brief Reset the pipeline. Queued frames are dropped.
+ *        Call it from the thread calling feed.
+ */
+void rtk_aivoice_pipeline_reset(struct aivoice_pipeline *pipeline);
+
+/**
+ * @brief Warm up the AFE node with a blob saved with aivoice_warmup.h, e.g. after power up.
+ *        The blob is replayed into the AFE node only, recognition does not see it
+ *        and no event is sent. Call it from the thread calling feed, before feeding.
+ *
+ * @retval  0: success;  -1: no AFE node or invalid blob.
+ */
+int rtk_aivoice_pipeline_warmup(struct aivoice_pipeline *pipeline, const void *buf, int len);
+
+/**
+ * @brief Feed audio, same as feed of aivoice_iface_afe_v1.
+ *        Pipelines without AFE node are fed with 16 ms mono frames.
+ *
+ * @retval  0: success;  others: error.
+ */
+int rtk_aivoice_pipeline_feed(struct aivoice_pipeline *pipeline, char *input_data, int length);
+
+/**
+ * @brief Register callback of the pipeline, same as rtk_aivoice_register_callback.
+ */
+void rtk_aivoice_pipeline_register_callback(struct aivoice_pipeline *pipeline,
+		aivoice_callback_handler cb, void *user_data);
+
+/**
+ * @brief Register callback of one node, e.g. to know which of several KWS models woke up.
+ *        Events of the node, and ASR_REC_TIMEOUT of its sessions for KWS nodes, go to this
+ *        callback instead of the pipeline callback. Register before feeding.
+ *
+ * @param[in] node  node id returned by rtk_aivoice_graph_add_node
+ * @param[in] cb    callback, NULL to send the events of the node to the pipeline callback again
+ *
+ * @retval  0: success;  -1: invalid node.
+ */
+int rtk_aivoice_pipeline_register_node_callback(struct aivoice_pipeline *pipeline, int node,
+		aivoice_callback_handler cb, void *user_data);
+
+/**
+ * @brief Update configuration of nodes without stopping the audio.
+ *        Call it from one thread at a time, not from callbacks of the pipeline.
+ *
+ * @param[in] pipeline  pipeline
+ * @param[in] node      node id returned by rtk_aivoice_graph_add_node, -1 for all nodes
+ * @param[in] config    NULL fields are not changed, the others are copied:
+ *                      afe/vad/kws/asr: new config of AFE/VAD/KWS/ASR nodes, each node only takes its own.
+ *                                       nodes whose config differs get new instances.
+ *                                       a new AFE config re-converges AEC/NS and restarts quality
+ *                                       adaption at full quality.
+ *                      common: only timeout is used, KWS nodes apply it from the next session.
+ *                      resource: not used.
+ *                      with staged start, nodes waiting for their models can not be updated.
+ *
+ * @retval  0: success, applied from the next frame;
+ *          -1: error, or an earlier update of the nodes or a quality step of AFE is not applied yet,
+ *              nothing is changed.
+ */
+int rtk_aivoice_pipeline_update_config(struct aivoice_pipeline *pipeline, int node,
+									   const struct aivoice_config *config);
+
+/**
+ * @brief Switch nodes to the models of another resource, between two frames.
+ *        New instances are created in the calling thread, as in rtk_aivoice_pipeline_update_config,
+ *        and the same thread rules apply.
+ *
+ * @param[in] pipeline  pipeline
+ * @param[in] node      VAD/KWS/ASR node id returned by rtk_aivoice_graph_add_node,
+ *                      -1 for every VAD/KWS/ASR node whose model type is in res
+ * @param[in] res       resource with the new models. the pipeline takes a reference of it,
+ *                      the caller can close its own reference after the call.
+ * @param[in] config    NULL to keep the module configs, or new module configs as in
+ *                      rtk_aivoice_pipeline_update_config, e.g. keywords of a new KWS model.
+ *
+ * @retval  0: success, applied from the next frame;
+ *          -1: error, or an earlier update of the nodes is not applied yet, nothing is changed.
+ */
+int rtk_aivoice_pipeline_swap_model(struct aivoice_pipeline *pipeline, int node,
+									struct aivoice_resource *res, const struct aivoice_config *config);
+
+/**
+ * @brief Staged start: create the modules waiting for their models, they run from the next frame.
+ *        Can be called from a background task, but not at the same time as
+ *        rtk_aivoice_pipeline_update_config.
+ *
+ * @param[in] pipeline  pipeline created with staged_start
+ * @param[in] resource  resource with the models of every module but AFE, set to aivoice_config.resource
+ *                      of those modules. it MUST stay valid until the pipeline is destroyed.
+ *
+ * @retval  0: success;  -1: error, or the models are already loaded.
+ */
+int rtk_aivoice_pipeline_load_models(struct aivoice_pipeline *pipeline, const char *resource);
+
+/**
+ * @brief Build the AFE instance of a quality step requested by feed. It is switched in by the next feed.
+ *        In threaded mode rtk_aivoice_pipeline_process calls it. Otherwise call it from a thread
+ *        other than feed, e.g. a low priority task every 100 ms; quality does not change without it.
+ *
+ * @retval  1: a new AFE is built;  0: no step is requested;  -1: the AFE can not be created, the level is kept.
+ */
+int rtk_aivoice_pipeline_adapt_quality(struct aivoice_pipeline *pipeline);
+
+/**
+ * @brief Register callback of quality transitions.
+ */
+void rtk_aivoice_pipeline_register_quality_callback(struct aivoice_pipeline *pipeline,
+		aivoice_quality_callback cb, void *user_data);
+
+/**
+ * @brief Run recognition on queued frames, in threaded mode.
+ *        Waits for frames at most timeout_ms, then processes every queued frame.
+ *        Usage in the worker thread:
+ *            while (rtk_aivoice_pipeline_process(pipeline, 100) >= 0);
+ *
+ * @retval  number of frames processed, -1 when the pipeline is stopped.
+ */
+int rtk_aivoice_pipeline_process(struct aivoice_pipeline *pipeline, int timeout_ms);
+
+/**
+ * @brief Make rtk_aivoice_pipeline_process return -1, to end the worker thread.
+ */
+void rtk_aivoice_pipeline_stop(struct aivoice_pipeline *pipeline);
+
+/**
+ * @brief Get counters of the pipeline.
+ */
+void rtk_aivoice_pipeline_get_stats(struct aivoice_pipeline *pipeline,
+									struct aivoice_pipeline_stats *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // _AIVOICE_PIPELINE_H_
@@ -0,0 +1,76 @@
+#ifndef _AIVOICE_REBLOCK_H_
+#define _AIVOICE_REBLOCK_H_
+
+#include "aivoice_interface.h"
+
+/*
+ * Feed with frame sizes other than 256 samples.
+ *
+ * The models of aivoice run on a fixed 256 samples (16 ms) hop, so
+ * afe_config.frame_size must stay 256. Reblock takes frames of any size
+ * and feeds the instance with 256 samples blocks:
+ *   - smaller frames (e.g. 128 samples, 8 ms) are accumulated, every
+ *     second frame triggers a feed. Capture and DMA can run on 8 ms
+ *     periods, but events and AFE output keep the 16 ms hop.
+ *   - larger frames (e.g. 512 samples, 32 ms) are split into blocks fed
+ *     in one call, without copy, which amortizes the per-call overhead
+ *     of the caller, e.g. queue and thread switches in offline processing.
+ * Samples of an incomplete block are kept until the next frame.
+ *
+ * Process time of the instance is measured in feed, to compare the cost
+ * of frame sizes, see the benchmark in example_full_flow_offline.c.
+ */
+
+struct aivoice_reblock_stats {
+	unsigned int frames;            /* frames fed to reblock */
+	unsigned int blocks;            /* 256 samples blocks fed to the instance */
+	long long process_us;           /* time spent in feed of the instance */
+};
+
+struct aivoice_reblock;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Create reblock on an aivoice instance.
+ *
+ * @param[in] iface         aivoice flow the instance was created with
+ * @param[in] handle        aivoice instance
+ * @param[in] channels      interleaved channels of the input, mic and ref channels for flows with afe,
+ *                          1 for flows without afe
+ * @param[in] frame_samples samples per channel of each frame fed to reblock
+ *
+ * @retval    reblock, or NULL to indicate an error.
+ */
+struct aivoice_reblock *rtk_aivoice_reblock_create(const struct rtk_aivoice_iface *iface, void *handle,
+		int channels, int frame_samples);
+
+/**
+ * @brief Destroy reblock. The aivoice instance is not destroyed.
+ */
+void rtk_aivoice_reblock_destroy(struct aivoice_reblock *reblock);
+
+/**
+ * @brief Feed one frame of channels * frame_samples interleaved samples.
+ *
+ * @retval  0: success;  -1: wrong length;  others: return value of feed of the iface.
+ */
+int rtk_aivoice_reblock_feed(struct aivoice_reblock *reblock, char *input_data, int length);
+
+/**
+ * @brief Drop samples of the incomplete block and reset the aivoice instance.
+ */
+void rtk_aivoice_reblock_reset(struct aivoice_reblock *reblock);
+
+/**
+ * @brief Get counters of reblock.
+ */
+void rtk_aivoice_reblock_get_stats(struct aivoice_reblock *reblock, struct aivoice_reblock_stats *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // _AIVOICE_REBLOCK_H_
@@ -0,0 +1,237 @@
+#ifndef _AIVOICE_RESOURCE_H_
+#define _AIVOICE_RESOURCE_H_
+
+/*
+ * aivoice binary resource (aivoice_models.bin, packed by tools/pack_resources).
+ *
+ * aivoice does not copy the resource internally, every instance created with
+ * aivoice_config.resource reads model weights and FST tables in place.
+ * So a resource loaded once can be shared by any number of instances,
+ * and each instance only allocates its own mutable state.
+ *
+ * A resource handle is reference counted:
+ *     res = rtk_aivoice_resource_open(flash_addr, 0);      // refcount 1
+ *     config.resource = rtk_aivoice_resource_data(res);
+ *     h1 = aivoice->create(&config);
+ *     h2 = aivoice->create(&config);                       // same weights
+ *     ...
+ *     rtk_aivoice_resource_retain(res) / rtk_aivoice_resource_close(res)
+ * Memory is released when the last reference is closed,
+ * which MUST be after every instance using it is destroyed.
+ *
+ * Open copies the whole resource to heap, models compressed by the packer
+ * (--lz4) are decoded straight into the heap copy. When the resource has
+ * crc32c digests, each model is verified while it is copied, and open fails
+ * on a mismatch, e.g. a broken OTA update. Bundles of model variants packed
+ * with --dedup store shared chunks once, open rebuilds each model from its
+ * chunks. To use it in place instead,
+ * map it: rtk_aivoice_resource_map takes a memory mapped region, e.g. the
+ * XIP flash address, and rtk_aivoice_resource_map_file maps a file (mmap
+ * on Linux). Only the header is read when mapping, model pages are read
+ * by the instances that use them, so startup time and resident memory
+ * follow the models in use.
+ *
+ * The models of a resource can be listed and looked up by type or name,
+ * and rtk_aivoice_resource_open_models copies only the models a flow
+ * needs into a smaller resource:
+ *     mask = rtk_aivoice_resource_models_of(&aivoice_iface_vad_v1, &config);
+ *     res = rtk_aivoice_resource_open_models(flash_addr, mask);
+ * rtk_aivoice_resource_open_replace loads a copy with one model replaced,
+ * e.g. the ASR commands with an FST compiled on the device (aivoice_fst.h).
+ */
+
+#include "aivoice_interface.h"
+
+#define AIVOICE_RESOURCE_ALIGNMENT  (16)                /* required alignment of aivoice_config.resource */
+#define AIVOICE_RESOURCE_MAX_SIZE   (4 * 1024 * 1024)   /* sanity limit of one resource */
+
+/* model types in the resource, same as MODEL_TYPES of aivoice_bin_packer.py */
+typedef enum {
+	AIVOICE_MODEL_AFE = 1,
+	AIVOICE_MODEL_VAD = 2,
+	AIVOICE_MODEL_KWS = 3,
+	AIVOICE_MODEL_ASR = 4,
+	AIVOICE_MODEL_FST = 5,      /* command grammar of ASR */
+	AIVOICE_MODEL_NNNS = 6,     /* NN noise suppression of AFE */
+	AIVOICE_MODEL_AGR = 7,      /* age and gender recognition of KWS */
+} aivoice_model_type_e;
+
+#define AIVOICE_MODEL_MASK(type)    (1u << (type))
+#define AIVOICE_MODEL_NAME_LEN      (32)
+
+struct aivoice_model_entry {
+	aivoice_model_type_e type;
+	unsigned int size;                  /* bytes of the model */
+	unsigned int offset;                /* offset of the model data from the resource start */
+	unsigned int stored_size;           /* bytes of the model data in the resource */
+	int compressed;                     /* 1: model data is lz4 compressed (aivoice_bin_packer.py --lz4) */
+	int chunked;                        /* 1: model is rebuilt from chunks shared with other models (--dedup) */
+	int has_crc;                        /* 1: crc is valid, the packer adds it unless --no-crc */
+	unsigned int crc;                   /* crc32c of the model data in the resource, of the rebuilt model if chunked */
+	char name[AIVOICE_MODEL_NAME_LEN];  /* bin file name without .bin, at most 31 chars */
+};
+
+struct aivoice_resource;
+
+struct aivoice_resource_info {
+	const char *data;           /* resource start address */
+	unsigned int size;          /* resource bytes */
+	int model_num;              /* number of models in resource */
+	int mapped;                 /* 1: used in place, 0: copied to heap */
+	int refcount;
+};
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Load an aivoice binary resource into memory and return a shared handle.
+ *
+ * @param[in] source    start address of the resource, e.g. flash address of aivoice_models.bin.
+ * @param[in] size      bytes of the resource; 0 to read it from the resource header.
+ *
+ * @retval    resource handle with refcount 1, or NULL to indicate an error.
+ */
+struct aivoice_resource *rtk_aivoice_resource_open(const void *source, unsigned int size);
+
+/**
+ * @brief Load only some models of an aivoice binary resource into memory.
+ *        Models not selected are not read from source.
+ *
+ * @param[in] source        start address of the resource, e.g. flash address of aivoice_models.bin.
+ * @param[in] model_mask    AIVOICE_MODEL_MASK() of the model types to load, missing types are skipped.
+ *
+ * @retval    resource handle with refcount 1, holding the selected models, or NULL to indicate an error.
+ */
+struct aivoice_resource *rtk_aivoice_resource_open_models(const void *source, unsigned int model_mask);
+
+/**
+ * @brief Load models by name, e.g. one variant of each type from a bundle
+ *        packed with aivoice_bin_packer.py --variants.
+ *
+ * @param[in] source        start address of the resource, e.g. flash address of aivoice_models.bin.
+ * @param[in] names         model names, compared with the first 31 chars
+ * @param[in] num_names     number of names
+ *
+ * @retval    resource handle with refcount 1, holding the named models, or NULL to indicate an error.
+ */
+struct aivoice_resource *rtk_aivoice_resource_open_names(const void *source, const char *const *names, int num_names);
+
+/**
+ * @brief Load a resource with one model replaced, e.g. an ASR command FST compiled
+ *        on the device by rtk_aivoice_fst_compile.
+ *
+ * @param[in] source    start address of the resource, e.g. flash address of aivoice_models.bin.
+ * @param[in] type      aivoice_model_type_e of the model, the first model of this type is replaced,
+ *                      the model is added when the resource has none.
+ * @param[in] model     model data, copied
+ * @param[in] size      bytes of model
+ * @param[in] name      model name, at most 31 chars are kept. NULL for no name
+ *
+ * @retval    resource handle with refcount 1, or NULL to indicate an error.
+ */
+struct aivoice_resource *rtk_aivoice_resource_open_replace(const void *source, int type,
+		const void *model, unsigned int size, const char *name);
+
+/**
+ * @brief Get the model types a flow needs.
+ *        It references every flow, so it is in aivoice_resource_models.c, and only
+ *        images calling it link all the flows.
+ *
+ * @param[in] iface     aivoice flow
+ * @param[in] config    configuration the flow is created with, for optional models
+ *                      (NNNS with AFE_NS_NN, AGR with enable_age_gender).
+ *                      NULL to include every optional model of the flow.
+ *
+ * @retval    AIVOICE_MODEL_MASK() of the model types, 0 for an unknown flow.
+ */
+unsigned int rtk_aivoice_resource_models_of(const struct rtk_aivoice_iface *iface,
+		const struct aivoice_config *config);
+
+/**
+ * @brief List models of an aivoice binary resource, only its header is read.
+ *
+ * @param[in]  source       start address of the resource, a loaded resource or flash
+ * @param[out] entries      models, can be NULL
+ * @param[in]  max_entries  size of entries
+ *
+ * @retval    number of models in the resource, can be larger than max_entries.
+ *            -1 when the resource is invalid.
+ */
+int rtk_aivoice_resource_list(const void *source, struct aivoice_model_entry *entries, int max_entries);
+
+/**
+ * @brief Find the first model matching type and name.
+ *
+ * @param[in]  source   start address of the resource, a loaded resource or flash
+ * @param[in]  type     model type, 0 for any type
+ * @param[in]  name     model name, NULL for any name. compared with the first 31 chars
+ * @param[out] entry    the model found
+ *
+ * @retval    0: found;  -1: not found or invalid resource.
+ */
+int rtk_aivoice_resource_find(const void *source, int type, const char *name, struct aivoice_model_entry *entry);
+
+/**
+ * @brief Use an aivoice binary resource in place, without copy.
+ *
+ * @param[in] addr      start address of the resource in a memory mapped region, e.g. XIP flash.
+ *                      MUST be AIVOICE_RESOURCE_ALIGNMENT aligned, and stay mapped until the
+ *                      last reference is closed.
+ *                      compressed or chunked resources can not be used in place.
+ * @param[in] size      bytes of the resource; 0 to read it from the resource header.
+ *
+ * @retval    resource handle with refcount 1, or NULL when addr is not aligned or the resource is invalid.
+ */
+struct aivoice_resource *rtk_aivoice_resource_map(const void *addr, unsigned int size);
+
+/**
+ * @brief Verify the crc32c digests of the models in place, e.g. after an OTA update
+ *        of a resource that will be mapped. Every model page is read.
+ *
+ * @param[in] source    start address of the resource
+ *
+ * @retval    number of models verified, 0 when the resource has no digests.
+ *            -1 on a mismatch or an invalid resource.
+ */
+int rtk_aivoice_resource_verify(const void *source);
+
+/**
+ * @brief Map an aivoice binary resource file read only, with aivoice_port_map_file.
+ *        The file is unmapped when the last reference is closed.
+ *
+ * @param[in] path      path of aivoice_models.bin
+ *
+ * @retval    resource handle with refcount 1, or NULL when the platform can not map files
+ *            or the resource is invalid.
+ */
+struct aivoice_resource *rtk_aivoice_resource_map_file(const char *path);
+
+/**
+ * @brief Take one more reference of the resource.
+ *
+ * @retval    res
+ */
+struct aivoice_resource *rtk_aivoice_resource_retain(struct aivoice_resource *res);
+
+/**
+ * @brief Drop one reference of the resource, memory is released with the last reference.
+ */
+void rtk_aivoice_resource_close(struct aivoice_resource *res);
+
+/**
+ * @brief Get the memory address to set to aivoice_config.resource.
+ */
+const char *rtk_aivoice_resource_data(const struct aivoice_resource *res);
+
+/**
+ * @brief Get information about the resource.
+ */
+void rtk_aivoice_resource_get_info(const struct aivoice_resource *res, struct aivoice_resource_info *info);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // _AIVOICE_RESOURCE_H_
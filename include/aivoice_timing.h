@@ -0,0 +1,104 @@
+#ifndef _AIVOICE_TIMING_H_
+#define _AIVOICE_TIMING_H_
+
+#include "aivoice_interface.h"
+
+/*
+ * Capture-timestamped feed, for end-to-end latency tracking.
+ *
+ * Feed through rtk_aivoice_feed_ts() with the capture time of each frame,
+ * then every event is delivered with an aivoice_event_stamp:
+ * the capture time of the frame whose feed produced it, and the time when
+ * it was produced. Latency of each event type is kept over a rolling window.
+ *
+ * All times are in microseconds of the same clock, aivoice_port_time_us()
+ * by default. Read the capture time with the same clock, e.g. when the DMA
+ * buffer of the frame is completed.
+ */
+
+#define AIVOICE_LATENCY_WINDOW      (64)    /* latencies kept for percentiles, per event type */
+#define AIVOICE_LATENCY_EVENT_NUM   (AIVOICE_EVOUT_AGE_GENDER_RESULT + 1)
+
+struct aivoice_event_stamp {
+	long long capture_us;       /* capture time of the frame that triggered the event, 0 if unknown */
+	long long complete_us;      /* time when processing of the event completed */
+	long long stream_start_us;  /* capture time of the first frame after reset,
+                                   absolute time of vad offset_ms is stream_start_us + offset_ms * 1000 */
+};
+
+struct aivoice_latency_stats {
+	unsigned int count;         /* events since create */
+	unsigned int window;        /* latencies used for the numbers below, up to AIVOICE_LATENCY_WINDOW */
+	long long min_us;
+	long long p50_us;
+	long long p90_us;
+	long long p99_us;
+	long long max_us;
+};
+
+/**
+ * @brief Event callback with time stamps, same as aivoice_callback_handler otherwise.
+ */
+typedef int (*aivoice_stamped_callback_handler)(void *user_data,
+		enum aivoice_out_event_type event_type,
+		const void *msg, int len,
+		const struct aivoice_event_stamp *stamp);
+
+struct aivoice_timing;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Attach timing to an aivoice instance.
+ *        It takes the callback of the instance, register callbacks to timing instead.
+ *
+ * @param[in] iface     aivoice flow the instance was created with
+ * @param[in] handle    aivoice instance
+ *
+ * @retval    timing, or NULL to indicate an error.
+ */
+struct aivoice_timing *rtk_aivoice_timing_create(const struct rtk_aivoice_iface *iface, void *handle);
+
+/**
+ * @brief Detach timing. The aivoice instance is not destroyed.
+ */
+void rtk_aivoice_timing_destroy(struct aivoice_timing *timing);
+
+/**
+ * @brief Register the callback that receives events and their stamps.
+ */
+void rtk_aivoice_timing_register_callback(struct aivoice_timing *timing,
+		aivoice_stamped_callback_handler cb, void *user_data);
+
+/**
+ * @brief Feed one frame of audio with its capture time.
+ *
+ * @param[in] timing            timing attached to the aivoice instance
+ * @param[in] input_data        same as feed of the iface
+ * @param[in] length            same as feed of the iface
+ * @param[in] capture_time_us   capture time of the frame
+ *
+ * @retval  return value of feed.
+ */
+int rtk_aivoice_feed_ts(struct aivoice_timing *timing, char *input_data, int length, long long capture_time_us);
+
+/**
+ * @brief Reset the aivoice instance, the next frame fed starts a new stream.
+ */
+void rtk_aivoice_timing_reset(struct aivoice_timing *timing);
+
+/**
+ * @brief Get latency (complete_us - capture_us) of one event type.
+ *        Call it from the thread calling feed, or between feeds.
+ */
+void rtk_aivoice_timing_get_latency(struct aivoice_timing *timing,
+									enum aivoice_out_event_type event_type,
+									struct aivoice_latency_stats *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // _AIVOICE_TIMING_H_
@@ -14,7 +14,8 @@ struct vad_config {
 	unsigned int left_margin;   /* Unit:ms. only affects offset_ms,
                                    it won't affect the event time of status 1.
                                    If you need get the audio during left_margin,
-                                   please implement a buffer to keep audio. */
+                                   please implement a buffer to keep audio,
+                                   or use aivoice_lookback.h. */
 	unsigned int right_margin;  /* Unit:ms. affects both offset_ms and event time of status 0. */
 	unsigned int min_speech_duration;  /* Unit:ms. Minimum speech duration to trigger speech status. */
 };
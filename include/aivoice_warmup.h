@@ -0,0 +1,101 @@
+#ifndef _AIVOICE_WARMUP_H_
+#define _AIVOICE_WARMUP_H_
+
+#include "aivoice_interface.h"
+
+/*
+ * AFE warm-up replay, for warm restart after power down.
+ *
+ * This does not save the state of an instance: adaptive state (AEC
+ * filters, noise estimates, AGC gains) lives inside the aivoice library and
+ * can not be read out. Instead, the recorder keeps the most recent input
+ * audio, and replay feeds it into a fresh AFE instance with callbacks
+ * suppressed, so AEC/NS/AGC start from a converged point instead of from
+ * scratch. Replay runs as fast as the CPU allows, but costs the full AFE
+ * processing time of the replayed audio, e.g. 2 seconds of AFE compute for
+ * history_ms 2000.
+ *
+ * Only aivoice_iface_afe_v1 instances, or the AFE node of a pipeline with
+ * rtk_aivoice_pipeline_warmup, are accepted. A flow with KWS, VAD or ASR
+ * would recognize what was said in the replayed audio.
+ *
+ * PRIVACY: the blob is raw microphone and reference audio, the last
+ * history_ms of what was said near the device before power down. Store it
+ * like a recording, e.g. encrypted or in protected flash, erase it once
+ * replayed, and never upload it.
+ *
+ * Usage:
+ *     rec = rtk_aivoice_warmup_recorder_create(frame_bytes, 2000);
+ *     loop: aivoice_iface_afe_v1.feed(handle, frame, frame_bytes);
+ *           rtk_aivoice_warmup_recorder_push(rec, frame, frame_bytes);
+ *     before power down: rtk_aivoice_warmup_save(rec, buf, &len), keep buf.
+ *     after power up:    handle = aivoice_iface_afe_v1.create(config);
+ *                        rtk_aivoice_warmup_replay(&aivoice_iface_afe_v1, handle, frame_bytes, buf, len,
+ *                                                  callback, user_data);
+ *
+ * The blob size is about history_ms / 16 * frame_bytes, e.g. 256 KB for
+ * 2 seconds of 2 mic + 1 ref input.
+ */
+
+#define AIVOICE_WARMUP_VERSION      (1)
+#define AIVOICE_WARMUP_HEADER_LEN   (24)
+
+struct aivoice_warmup_recorder;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Create a recorder keeping the most recent input frames.
+ *
+ * @param[in] frame_bytes   bytes of one frame fed to the AFE
+ * @param[in] history_ms    input audio kept, 1000~3000 ms is enough for AEC and NS to converge
+ *
+ * @retval    recorder, or NULL to indicate an error.
+ */
+struct aivoice_warmup_recorder *rtk_aivoice_warmup_recorder_create(int frame_bytes, int history_ms);
+
+void rtk_aivoice_warmup_recorder_destroy(struct aivoice_warmup_recorder *rec);
+
+/**
+ * @brief Record one frame that was fed to the AFE.
+ *
+ * @retval  0: success;  -1: length is not frame_bytes.
+ */
+int rtk_aivoice_warmup_recorder_push(struct aivoice_warmup_recorder *rec, const char *input_data, int length);
+
+/**
+ * @brief Serialize the recorded audio into a versioned blob.
+ *
+ * @param[in]     rec   recorder
+ * @param[out]    buf   blob, NULL to only query the size
+ * @param[in,out] len   size of buf as input, size of the blob as output
+ *
+ * @retval  0: success;  -1: buf is too small.
+ */
+int rtk_aivoice_warmup_save(struct aivoice_warmup_recorder *rec, void *buf, int *len);
+
+/**
+ * @brief Warm up an AFE instance by replaying the blob,
+ *        then register cb to the instance.
+ *
+ * @param[in] iface         flow of the instance, must be aivoice_iface_afe_v1
+ * @param[in] handle        AFE instance, usually just created or reset
+ * @param[in] frame_bytes   bytes of one frame the instance takes, the blob must be recorded with the same
+ * @param[in] buf           blob from rtk_aivoice_warmup_save
+ * @param[in] len           size of the blob
+ * @param[in] cb            callback registered after replay
+ * @param[in] user_data     user data of cb
+ *
+ * @retval  0: success;  -1: iface is not aivoice_iface_afe_v1, or invalid blob.
+ */
+int rtk_aivoice_warmup_replay(const struct rtk_aivoice_iface *iface, void *handle, int frame_bytes,
+							  const void *buf, int len,
+							  aivoice_callback_handler cb, void *user_data);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // _AIVOICE_WARMUP_H_
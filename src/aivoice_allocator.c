@@ -0,0 +1,168 @@
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "aivoice_allocator.h"
+
+#define MIN_ALIGNMENT   (8)
+
+static void *heap_aligned_alloc(void *user_data, size_t size, size_t alignment, aivoice_memory_class_e mem_class);
+static void *heap_alloc(void *user_data, size_t size, aivoice_memory_class_e mem_class);
+static void heap_free(void *user_data, void *ptr);
+
+static struct aivoice_allocator g_allocator = {
+	.alloc = heap_alloc,
+	.aligned_alloc = heap_aligned_alloc,
+	.free = heap_free,
+	.user_data = NULL,
+};
+
+static size_t align_up(size_t value, size_t alignment)
+{
+	return (value + alignment - 1) & ~(alignment - 1);
+}
+
+/* default heap allocator: the address returned by malloc is kept right before the aligned block */
+static void *heap_aligned_alloc(void *user_data, size_t size, size_t alignment, aivoice_memory_class_e mem_class)
+{
+	(void)user_data;
+	(void)mem_class;
+
+	if (alignment < MIN_ALIGNMENT) {
+		alignment = MIN_ALIGNMENT;
+	}
+
+	char *raw = (char *)malloc(size + alignment + sizeof(void *));
+	if (!raw) {
+		return NULL;
+	}
+
+	uintptr_t aligned = align_up((uintptr_t)(raw + sizeof(void *)), alignment);
+	((void **)aligned)[-1] = raw;
+	return (void *)aligned;
+}
+
+static void *heap_alloc(void *user_data, size_t size, aivoice_memory_class_e mem_class)
+{
+	return heap_aligned_alloc(user_data, size, MIN_ALIGNMENT, mem_class);
+}
+
+static void heap_free(void *user_data, void *ptr)
+{
+	(void)user_data;
+
+	if (ptr) {
+		free(((void **)ptr)[-1]);
+	}
+}
+
+void rtk_aivoice_set_allocator(const struct aivoice_allocator *allocator)
+{
+	if (allocator) {
+		g_allocator = *allocator;
+	} else {
+		g_allocator.alloc = heap_alloc;
+		g_allocator.aligned_alloc = heap_aligned_alloc;
+		g_allocator.free = heap_free;
+		g_allocator.user_data = NULL;
+	}
+}
+
+void *rtk_aivoice_mem_alloc(size_t size, aivoice_memory_class_e mem_class)
+{
+	return g_allocator.alloc(g_allocator.user_data, size, mem_class);
+}
+
+void *rtk_aivoice_mem_calloc(size_t size, aivoice_memory_class_e mem_class)
+{
+	void *ptr = rtk_aivoice_mem_alloc(size, mem_class);
+	if (ptr) {
+		memset(ptr, 0, size);
+	}
+	return ptr;
+}
+
+void *rtk_aivoice_mem_aligned_alloc(size_t size, size_t alignment, aivoice_memory_class_e mem_class)
+{
+	return g_allocator.aligned_alloc(g_allocator.user_data, size, alignment, mem_class);
+}
+
+void rtk_aivoice_mem_free(void *ptr)
+{
+	if (ptr) {
+		g_allocator.free(g_allocator.user_data, ptr);
+	}
+}
+
+/*****************************************************************************/
+//                              arena allocator
+/*****************************************************************************/
+void rtk_aivoice_arena_init(struct aivoice_arena *arena, void *buffer, size_t size)
+{
+	arena->base = (char *)buffer;
+	arena->size = size;
+	arena->used = 0;
+}
+
+void rtk_aivoice_arena_reset(struct aivoice_arena *arena)
+{
+	arena->used = 0;
+}
+
+static void *arena_aligned_alloc(void *user_data, size_t size, size_t alignment, aivoice_memory_class_e mem_class)
+{
+	struct aivoice_arena_allocator *arena_allocator = (struct aivoice_arena_allocator *)user_data;
+	struct aivoice_arena *arena = NULL;
+
+	if ((int)mem_class >= 0 && mem_class < AIVOICE_MEMORY_CLASS_NUM) {
+		arena = arena_allocator->arenas[mem_class];
+	}
+	if (!arena) {
+		return heap_aligned_alloc(NULL, size, alignment, mem_class);
+	}
+
+	if (alignment < MIN_ALIGNMENT) {
+		alignment = MIN_ALIGNMENT;
+	}
+
+	// threads allocating at the same time each claim their block by moving used forward
+	uintptr_t end = (uintptr_t)arena->base + arena->size;
+	size_t used;
+	uintptr_t start;
+	do {
+		used = arena->used;
+		start = align_up((uintptr_t)arena->base + used, alignment);
+		if (start > end || size > end - start) {
+			return NULL;
+		}
+	} while (!__sync_bool_compare_and_swap(&arena->used, used, start + size - (uintptr_t)arena->base));
+
+	return (void *)start;
+}
+
+static void *arena_alloc(void *user_data, size_t size, aivoice_memory_class_e mem_class)
+{
+	return arena_aligned_alloc(user_data, size, MIN_ALIGNMENT, mem_class);
+}
+
+static void arena_free(void *user_data, void *ptr)
+{
+	struct aivoice_arena_allocator *arena_allocator = (struct aivoice_arena_allocator *)user_data;
+
+	for (int i = 0; i < AIVOICE_MEMORY_CLASS_NUM; i++) {
+		struct aivoice_arena *arena = arena_allocator->arenas[i];
+		if (arena && (char *)ptr >= arena->base && (char *)ptr < arena->base + arena->size) {
+			return; // released by rtk_aivoice_arena_reset
+		}
+	}
+	heap_free(NULL, ptr);
+}
+
+void rtk_aivoice_arena_allocator(struct aivoice_arena_allocator *arena_allocator,
+								 struct aivoice_allocator *allocator)
+{
+	allocator->alloc = arena_alloc;
+	allocator->aligned_alloc = arena_aligned_alloc;
+	allocator->free = arena_free;
+	allocator->user_data = arena_allocator;
+}
@@ -0,0 +1,108 @@
+#include <string.h>
+#include <stdint.h>
+
+#include "aivoice_crc32c.h"
+
+#if defined(__ARM_FEATURE_CRC32)
+#include <arm_acle.h>
+#elif defined(__SSE4_2__)
+#include <nmmintrin.h>
+#endif
+
+#if defined(__ARM_FEATURE_CRC32) || defined(__SSE4_2__)
+
+static uint32_t crc32c_update(uint32_t crc, const uint8_t *p, unsigned int len)
+{
+	uint32_t word;
+
+#if defined(__aarch64__) || defined(__x86_64__)
+	uint64_t dword;
+
+	while (len >= 8) {
+		memcpy(&dword, p, 8);
+#if defined(__ARM_FEATURE_CRC32)
+		crc = __crc32cd(crc, dword);
+#else
+		crc = (uint32_t)_mm_crc32_u64(crc, dword);
+#endif
+		p += 8;
+		len -= 8;
+	}
+#endif
+	while (len >= 4) {
+		memcpy(&word, p, 4);
+#if defined(__ARM_FEATURE_CRC32)
+		crc = __crc32cw(crc, word);
+#else
+		crc = _mm_crc32_u32(crc, word);
+#endif
+		p += 4;
+		len -= 4;
+	}
+	while (len--) {
+#if defined(__ARM_FEATURE_CRC32)
+		crc = __crc32cb(crc, *p++);
+#else
+		crc = _mm_crc32_u8(crc, *p++);
+#endif
+	}
+	return crc;
+}
+
+#else
+
+#define CRC32C_POLY     (0x82f63b78u)   /* reflected 0x1edc6f41 */
+
+static uint32_t crc_table[4][256];
+static volatile int crc_table_ready;
+
+/*
+ * Built on the first call. Concurrent first calls each build the table, writing
+ * the same values, and the barriers make sure a thread seeing crc_table_ready
+ * also sees the complete table.
+ */
+static void build_table(void)
+{
+	for (uint32_t i = 0; i < 256; i++) {
+		uint32_t crc = i;
+		for (int k = 0; k < 8; k++) {
+			crc = (crc >> 1) ^ (CRC32C_POLY & (0u - (crc & 1)));
+		}
+		crc_table[0][i] = crc;
+	}
+	for (uint32_t i = 0; i < 256; i++) {
+		for (int t = 1; t < 4; t++) {
+			crc_table[t][i] = (crc_table[t - 1][i] >> 8) ^ crc_table[0][crc_table[t - 1][i] & 0xff];
+		}
+	}
+	__sync_synchronize();
+	crc_table_ready = 1;
+}
+
+static uint32_t crc32c_update(uint32_t crc, const uint8_t *p, unsigned int len)
+{
+	if (!crc_table_ready) {
+		build_table();
+	}
+	__sync_synchronize();
+
+	// slicing by 4, bytes are combined explicitly so it works on any endian
+	while (len >= 4) {
+		crc ^= (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+		crc = crc_table[3][crc & 0xff] ^ crc_table[2][(crc >> 8) & 0xff] ^
+			  crc_table[1][(crc >> 16) & 0xff] ^ crc_table[0][crc >> 24];
+		p += 4;
+		len -= 4;
+	}
+	while (len--) {
+		crc = (crc >> 8) ^ crc_table[0][(crc ^ *p++) & 0xff];
+	}
+	return crc;
+}
+
+#endif
+
+unsigned int aivoice_crc32c(unsigned int crc, const void *data, unsigned int len)
+{
+	return ~crc32c_update(~(uint32_t)crc, (const uint8_t *)data, len);
+}
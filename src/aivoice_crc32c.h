@@ -0,0 +1,18 @@
+#ifndef _AIVOICE_CRC32C_H_
+#define _AIVOICE_CRC32C_H_
+
+/*
+ * CRC32C (Castagnoli) of model data, used to verify resources,
+ * not part of the public api.
+ */
+
+/*
+ * Update crc with len bytes of data, start with crc 0, e.g.
+ *     crc = aivoice_crc32c(0, part1, len1);
+ *     crc = aivoice_crc32c(crc, part2, len2);
+ * Uses the crc32c instructions when the compiler targets them
+ * (ARMv8 +crc, SSE4.2), a slicing-by-4 table otherwise.
+ */
+unsigned int aivoice_crc32c(unsigned int crc, const void *data, unsigned int len);
+
+#endif // _AIVOICE_CRC32C_H_
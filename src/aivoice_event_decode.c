@@ -0,0 +1,298 @@
+#include <string.h>
+
+#include "aivoice_event_decode.h"
+
+/*
+ * A minimal json scanner for the small, flat messages of aivoice.
+ * Values are located in place, nothing is allocated or copied.
+ */
+
+static const char *skip_ws(const char *p, const char *end)
+{
+	while (p < end && (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n')) {
+		p++;
+	}
+	return p;
+}
+
+static const char *skip_string(const char *p, const char *end)
+{
+	// p points to the opening quote
+	for (p++; p < end; p++) {
+		if (*p == '\\') {
+			p++;
+		} else if (*p == '"') {
+			return p + 1;
+		}
+	}
+	return NULL;
+}
+
+static const char *skip_value(const char *p, const char *end)
+{
+	int depth = 0;
+
+	while (p && p < end) {
+		switch (*p) {
+		case '"':
+			p = skip_string(p, end);
+			if (depth == 0) {
+				return p;
+			}
+			continue;
+		case '{':
+		case '[':
+			depth++;
+			break;
+		case '}':
+		case ']':
+			if (depth == 0) {
+				return p;
+			}
+			if (--depth == 0) {
+				return p + 1;
+			}
+			break;
+		case ',':
+			if (depth == 0) {
+				return p;
+			}
+			break;
+		default:
+			break;
+		}
+		p++;
+	}
+	return p;
+}
+
+/* find member "key" of the object starting at p, return the start of its value */
+static const char *find_member(const char *p, const char *end, const char *key)
+{
+	size_t key_len = strlen(key);
+
+	p = skip_ws(p, end);
+	if (p >= end || *p != '{') {
+		return NULL;
+	}
+	p++;
+
+	while (p && p < end) {
+		p = skip_ws(p, end);
+		if (p >= end || *p != '"') {
+			return NULL;
+		}
+
+		const char *name = p + 1;
+		p = skip_string(p, end);
+		if (!p) {
+			return NULL;
+		}
+		size_t name_len = (size_t)(p - 1 - name);
+
+		p = skip_ws(p, end);
+		if (p >= end || *p != ':') {
+			return NULL;
+		}
+		p = skip_ws(p + 1, end);
+
+		if (name_len == key_len && memcmp(name, key, key_len) == 0) {
+			return p;
+		}
+
+		p = skip_ws(skip_value(p, end), end);
+		if (!p || p >= end || *p != ',') {
+			return NULL;
+		}
+		p++;
+	}
+	return NULL;
+}
+
+static int parse_number(const char *p, const char *end, double *out)
+{
+	double value = 0;
+	double scale = 1;
+	int sign = 1;
+	int exp = 0;
+	int exp_sign = 1;
+	int digits = 0;
+
+	if (!p || p >= end) {
+		return -1;
+	}
+	if (*p == '-') {
+		sign = -1;
+		p++;
+	}
+	for (; p < end && *p >= '0' && *p <= '9'; p++, digits++) {
+		value = value * 10 + (*p - '0');
+	}
+	if (p < end && *p == '.') {
+		for (p++; p < end && *p >= '0' && *p <= '9'; p++, digits++) {
+			scale /= 10;
+			value += (*p - '0') * scale;
+		}
+	}
+	if (!digits) {
+		return -1;
+	}
+	if (p < end && (*p == 'e' || *p == 'E')) {
+		p++;
+		if (p < end && (*p == '-' || *p == '+')) {
+			exp_sign = *p == '-' ? -1 : 1;
+			p++;
+		}
+		// larger exponents only give inf or 0
+		for (; p < end && *p >= '0' && *p <= '9'; p++) {
+			if (exp < 400) {
+				exp = exp * 10 + (*p - '0');
+			}
+		}
+		while (exp-- > 0) {
+			value = exp_sign > 0 ? value * 10 : value / 10;
+		}
+	}
+
+	*out = sign * value;
+	return 0;
+}
+
+static int get_number(const char *obj, const char *end, const char *key, double *out)
+{
+	return parse_number(find_member(obj, end, key), end, out);
+}
+
+static int string_equals(const char *p, const char *end, const char *str)
+{
+	size_t n = strlen(str);
+
+	if (!p || p >= end || *p != '"' || (size_t)(end - p) < n + 2) {
+		return 0;
+	}
+	return memcmp(p + 1, str, n) == 0 && p[n + 1] == '"';
+}
+
+static const char *json_end(const char *json, int len)
+{
+	return json + (len >= 0 ? (size_t)len : strlen(json));
+}
+
+int rtk_aivoice_decode_wakeup(const char *json, int len, struct aivoice_evout_wakeup *out)
+{
+	const char *end;
+	double v;
+
+	if (!json || !out) {
+		return -1;
+	}
+	end = json_end(json, len);
+	memset(out, 0, sizeof(*out));
+
+	if (get_number(json, end, "id", &v) != 0) {
+		return -1;
+	}
+	out->id = (int)v;
+	if (get_number(json, end, "score", &v) == 0) {
+		out->score = (float)v;
+	}
+	return 0;
+}
+
+int rtk_aivoice_decode_asr(const char *json, int len, struct aivoice_evout_asr *out)
+{
+	const char *end;
+	const char *p;
+	double v;
+
+	if (!json || !out) {
+		return -1;
+	}
+	end = json_end(json, len);
+	memset(out, 0, sizeof(*out));
+
+	p = find_member(json, end, "commands");
+	if (!p || p >= end || *p != '[') {
+		return -1;
+	}
+
+	for (p = skip_ws(p + 1, end); p < end && *p == '{';) {
+		if (out->num_commands < AIVOICE_ASR_MAX_COMMANDS &&
+			get_number(p, end, "id", &v) == 0) {
+			out->command_ids[out->num_commands++] = (int)v;
+		}
+		p = skip_ws(skip_value(p, end), end);
+		if (!p || p >= end || *p != ',') {
+			break;
+		}
+		p = skip_ws(p + 1, end);
+	}
+
+	if (get_number(json, end, "type", &v) == 0) {
+		out->type = (int)v;
+	}
+	if (get_number(json, end, "conf", &v) == 0) {
+		out->conf = (float)v;
+	}
+	return 0;
+}
+
+int rtk_aivoice_decode_age_gender(const char *json, int len, struct aivoice_evout_age_gender *out)
+{
+	static const char *const names[] = {"child", "adult_female", "adult_male"};
+	const char *end;
+	const char *p;
+	double v;
+
+	if (!json || !out) {
+		return -1;
+	}
+	end = json_end(json, len);
+	out->result = AIVOICE_AGE_GENDER_UNKNOWN;
+
+	p = find_member(json, end, "result");
+	if (!p) {
+		p = find_member(json, end, "type");
+	}
+	if (!p) {
+		return -1;
+	}
+
+	if (parse_number(p, end, &v) == 0) {
+		if (v >= AIVOICE_AGE_GENDER_CHILD && v <= AIVOICE_AGE_GENDER_ADULT_MALE) {
+			out->result = (aivoice_age_gender_e)(int)v;
+		}
+		return 0;
+	}
+	for (int i = 0; i < (int)(sizeof(names) / sizeof(names[0])); i++) {
+		if (string_equals(p, end, names[i])) {
+			out->result = (aivoice_age_gender_e)i;
+			return 0;
+		}
+	}
+	return -1;
+}
+
+int rtk_aivoice_decode_afe_info(const char *json, int len, struct aivoice_evout_afe_info *out)
+{
+	const char *end;
+	double v;
+
+	if (!out) {
+		return -1;
+	}
+	memset(out, 0, sizeof(*out));
+	if (!json) {
+		return 0;
+	}
+	end = json_end(json, len);
+
+	if (get_number(json, end, "abnormal_flag", &v) == 0 && v != 0) {
+		out->flags |= AIVOICE_AFE_FLAG_ABNORMAL;
+	}
+	if (get_number(json, end, "ssl_angle", &v) == 0 && v >= 0) {
+		out->flags |= AIVOICE_AFE_FLAG_SSL_ANGLE;
+		out->ssl_angle = (float)v;
+	}
+	return 0;
+}
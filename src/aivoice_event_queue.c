@@ -0,0 +1,306 @@
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "aivoice_event_queue.h"
+#include "aivoice_allocator.h"
+#include "aivoice_port.h"
+
+#define EQ_LOGE(x, ...) printf("[AIVOICE] [EVQ] error: " x, ##__VA_ARGS__)
+
+#define rmb()  __sync_synchronize()
+#define wmb()  __sync_synchronize()
+
+struct aivoice_event_queue {
+	struct aivoice_event *events;
+	uint32_t capacity;
+	uint32_t mask;
+
+	char *audio;
+	uint32_t audio_slots;
+	uint32_t audio_mask;
+	uint32_t audio_slot_bytes;
+	uint32_t channel_bytes;
+	int payload;
+	struct aivoice_lookback *lookback;
+
+	/* written by producer only */
+	volatile uint32_t head;
+	volatile uint32_t audio_head;
+
+	/* written by consumer only */
+	volatile uint32_t tail;
+	volatile uint32_t audio_tail;
+	uint32_t audio_in_use;              /* slots handed out by the last poll */
+
+	struct aivoice_event_queue_stats stats;
+};
+
+static int is_power_of_2(int n)
+{
+	return n > 0 && (n & (n - 1)) == 0;
+}
+
+struct aivoice_event_queue *rtk_aivoice_event_queue_create(const struct aivoice_event_queue_config *config)
+{
+	struct aivoice_event_queue_config default_config = AIVOICE_EVENT_QUEUE_CONFIG_DEFAULT();
+	if (!config) {
+		config = &default_config;
+	}
+
+	if (!is_power_of_2(config->capacity)) {
+		EQ_LOGE("capacity %d is not power of 2\n", config->capacity);
+		return NULL;
+	}
+	if (config->audio_slots != 0 &&
+		(!is_power_of_2(config->audio_slots) || config->audio_slot_bytes <= 0 || config->channel_bytes < 0)) {
+		EQ_LOGE("invalid audio slots %d x %d bytes\n", config->audio_slots, config->audio_slot_bytes);
+		return NULL;
+	}
+
+	struct aivoice_event_queue *queue = (struct aivoice_event_queue *)rtk_aivoice_mem_calloc(
+											 sizeof(*queue), AIVOICE_MEMORY_CLASS_STATE);
+	if (!queue) {
+		return NULL;
+	}
+
+	queue->capacity = (uint32_t)config->capacity;
+	queue->mask = queue->capacity - 1;
+	queue->payload = config->payload ? config->payload : AIVOICE_EVENT_PAYLOAD_JSON;
+	queue->events = (struct aivoice_event *)rtk_aivoice_mem_calloc(
+						(size_t)queue->capacity * sizeof(struct aivoice_event), AIVOICE_MEMORY_CLASS_STATE);
+
+	if (config->audio_slots > 0) {
+		queue->audio_slots = (uint32_t)config->audio_slots;
+		queue->audio_mask = queue->audio_slots - 1;
+		queue->audio_slot_bytes = (uint32_t)config->audio_slot_bytes;
+		queue->channel_bytes = config->channel_bytes ? (uint32_t)config->channel_bytes : queue->audio_slot_bytes;
+		queue->audio = (char *)rtk_aivoice_mem_alloc(
+						   (size_t)queue->audio_slots * queue->audio_slot_bytes, AIVOICE_MEMORY_CLASS_SCRATCH);
+	}
+
+	if (!queue->events || (queue->audio_slots && !queue->audio)) {
+		rtk_aivoice_event_queue_destroy(queue);
+		return NULL;
+	}
+
+	return queue;
+}
+
+void rtk_aivoice_event_queue_destroy(struct aivoice_event_queue *queue)
+{
+	if (!queue) {
+		return;
+	}
+
+	rtk_aivoice_mem_free(queue->events);
+	rtk_aivoice_mem_free(queue->audio);
+	rtk_aivoice_mem_free(queue);
+}
+
+void rtk_aivoice_event_queue_reset(struct aivoice_event_queue *queue)
+{
+	queue->head = 0;
+	queue->tail = 0;
+	queue->audio_head = 0;
+	queue->audio_tail = 0;
+	queue->audio_in_use = 0;
+	memset(&queue->stats, 0, sizeof(queue->stats));
+}
+
+static int decode_typed(struct aivoice_event *ev)
+{
+	switch (ev->type) {
+	case AIVOICE_EVOUT_AFE:
+		return rtk_aivoice_decode_afe_info(ev->msg, -1, &ev->afe_info);
+	case AIVOICE_EVOUT_WAKEUP:
+		return rtk_aivoice_decode_wakeup(ev->msg, -1, &ev->u.wakeup);
+	case AIVOICE_EVOUT_ASR_RESULT:
+		return rtk_aivoice_decode_asr(ev->msg, -1, &ev->u.asr);
+	case AIVOICE_EVOUT_AGE_GENDER_RESULT:
+		return rtk_aivoice_decode_age_gender(ev->msg, -1, &ev->u.age_gender);
+	default:
+		return 0;
+	}
+}
+
+static void copy_msg(struct aivoice_event_queue *queue, struct aivoice_event *ev, const char *msg, int len)
+{
+	// typed payloads are decoded from the copy by the consumer
+	if (!(queue->payload & (AIVOICE_EVENT_PAYLOAD_JSON | AIVOICE_EVENT_PAYLOAD_TYPED))) {
+		ev->msg[0] = '\0';
+		return;
+	}
+
+	size_t n = msg ? (len >= 0 ? (size_t)len : strlen(msg)) : 0;
+
+	if (n >= AIVOICE_EVENT_MSG_MAX_LEN) {
+		n = AIVOICE_EVENT_MSG_MAX_LEN - 1;
+		queue->stats.truncated_msgs++;
+	}
+	if (n) {
+		memcpy(ev->msg, msg, n);
+	}
+	ev->msg[n] = '\0';
+}
+
+static int push_event(struct aivoice_event_queue *queue, enum aivoice_out_event_type event_type,
+					  const void *msg, int len, const struct aivoice_event_stamp *stamp)
+{
+	struct aivoice_audio_segment segment;
+	uint32_t head = queue->head;
+	uint32_t used = head - queue->tail;
+
+	// keep the lookback audio continuous, even when the event is dropped
+	if (!queue->lookback ||
+		!rtk_aivoice_lookback_on_event(queue->lookback, event_type, msg, len, &segment)) {
+		memset(&segment, 0, sizeof(segment));
+	}
+
+	if (used >= queue->capacity) {
+		queue->stats.dropped_events++;
+		return -1;
+	}
+
+	struct aivoice_event *ev = &queue->events[head & queue->mask];
+	ev->segment = segment;
+	ev->type = event_type;
+	ev->len = len;
+	ev->audio_slot = -1;
+	if (stamp) {
+		ev->stamp = *stamp;
+	} else {
+		memset(&ev->stamp, 0, sizeof(ev->stamp));
+		ev->stamp.complete_us = aivoice_port_time_us();
+	}
+
+	switch (event_type) {
+	case AIVOICE_EVOUT_VAD:
+		memcpy(&ev->u.vad, msg, sizeof(ev->u.vad));
+		ev->msg[0] = '\0';
+		break;
+
+	case AIVOICE_EVOUT_AFE: {
+		const struct aivoice_evout_afe *afe = (const struct aivoice_evout_afe *)msg;
+		uint32_t audio_head = queue->audio_head;
+
+		ev->u.afe.ch_num = afe->ch_num;
+		ev->u.afe.data = NULL;
+		if (queue->audio_slots && afe->data) {
+			if (audio_head - queue->audio_tail < queue->audio_slots) {
+				uint32_t slot = audio_head & queue->audio_mask;
+				uint32_t bytes = afe->ch_num > 0 ? (uint32_t)afe->ch_num * queue->channel_bytes : queue->channel_bytes;
+				if (bytes > queue->audio_slot_bytes) {
+					// keep the channels that fit whole
+					bytes = queue->audio_slot_bytes;
+					ev->u.afe.ch_num = (int)(bytes / queue->channel_bytes);
+					queue->stats.dropped_audio++;
+				}
+				memcpy(queue->audio + slot * queue->audio_slot_bytes, afe->data, bytes);
+				ev->audio_slot = (int)slot;
+				queue->audio_head = audio_head + 1;
+			} else {
+				queue->stats.dropped_audio++;
+			}
+		}
+		copy_msg(queue, ev, afe->out_others_json, -1);
+		break;
+	}
+
+	case AIVOICE_EVOUT_ASR_REC_TIMEOUT:
+		ev->msg[0] = '\0';
+		break;
+
+	default: // json message
+		copy_msg(queue, ev, (const char *)msg, len);
+		break;
+	}
+
+	wmb();
+	queue->head = head + 1;
+
+	queue->stats.pushed++;
+	if (used + 1 > queue->stats.high_watermark) {
+		queue->stats.high_watermark = used + 1;
+	}
+
+	return 0;
+}
+
+int rtk_aivoice_event_queue_handler(void *user_data,
+									enum aivoice_out_event_type event_type,
+									const void *msg, int len)
+{
+	return push_event((struct aivoice_event_queue *)user_data, event_type, msg, len, NULL);
+}
+
+int rtk_aivoice_event_queue_stamped_handler(void *user_data,
+		enum aivoice_out_event_type event_type,
+		const void *msg, int len,
+		const struct aivoice_event_stamp *stamp)
+{
+	return push_event((struct aivoice_event_queue *)user_data, event_type, msg, len, stamp);
+}
+
+void rtk_aivoice_register_event_queue(void *handle, struct aivoice_event_queue *queue)
+{
+	rtk_aivoice_register_callback(handle, rtk_aivoice_event_queue_handler, queue);
+}
+
+void rtk_aivoice_event_queue_attach_lookback(struct aivoice_event_queue *queue,
+		struct aivoice_lookback *lookback)
+{
+	queue->lookback = lookback;
+}
+
+int rtk_aivoice_poll_events(struct aivoice_event_queue *queue,
+							struct aivoice_event *events, int max)
+{
+	// audio handed out by the last poll is not referenced any more
+	if (queue->audio_in_use) {
+		rmb();
+		queue->audio_tail += queue->audio_in_use;
+		queue->audio_in_use = 0;
+	}
+
+	uint32_t head = queue->head;  // Get snapshot of head
+	uint32_t tail = queue->tail;
+	int count = 0;
+
+	rmb();
+	while (tail != head && count < max) {
+		struct aivoice_event *ev = &events[count];
+		memcpy(ev, &queue->events[tail & queue->mask], sizeof(*ev));
+
+		if (queue->payload & AIVOICE_EVENT_PAYLOAD_TYPED) {
+			if (decode_typed(ev) != 0) {
+				queue->stats.decode_errors++;
+			}
+			if (!(queue->payload & AIVOICE_EVENT_PAYLOAD_JSON)) {
+				ev->msg[0] = '\0';
+			}
+		}
+		if (ev->type == AIVOICE_EVOUT_AFE) {
+			ev->u.afe.out_others_json = ev->msg;
+			if (ev->audio_slot >= 0) {
+				ev->u.afe.data = (short *)(queue->audio + (uint32_t)ev->audio_slot * queue->audio_slot_bytes);
+				queue->audio_in_use++;
+			}
+		}
+
+		tail++;
+		count++;
+	}
+
+	rmb();
+	queue->tail = tail;
+	queue->stats.polled += (unsigned int)count;
+
+	return count;
+}
+
+void rtk_aivoice_event_queue_get_stats(struct aivoice_event_queue *queue,
+									   struct aivoice_event_queue_stats *stats)
+{
+	memcpy(stats, &queue->stats, sizeof(*stats));
+}
@@ -0,0 +1,469 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "aivoice_fst.h"
+#include "aivoice_allocator.h"
+
+#define FST_LOGE(x, ...) printf("[AIVOICE] [FST] error: " x, ##__VA_ARGS__)
+
+/* FST binary, the format of fst_cn_cmd_ac40.bin, little endian */
+#define FST_MAGIC               "AIVOICE\0FST\0"
+#define FST_MAGIC_LEN           (12)
+#define FST_OFFSET_SIZE         (16)
+#define FST_OFFSET_VERSION      (20)
+#define FST_OFFSET_SECTIONS     (24)
+#define FST_HEADER_LEN          (32)    /* magic, reserved, total size, version, section count, reserved */
+#define FST_VERSION             (1)
+#define FST_SECTION_HEADER_LEN  (16)    /* type, data size, reserved */
+#define FST_SECTION_SYMBOLS     (0x0e)  /* symbol count, offsets from the count, strings */
+#define FST_SECTION_GRAPH       (0x0f)  /* graph header and arcs */
+#define FST_GRAPH_HEADER_LEN    (16)    /* u16: reserved, states, arcs, units, start, final, filler, reserved */
+#define FST_ARC_LEN             (8)     /* u16: src, dst, unit, command */
+#define FST_ALIGNMENT           (16)    /* sections and trailer */
+#define FST_TRAILER             "END\0END\0END\0END\0"
+#define FST_TRAILER_LEN         (16)
+#define FST_EPS                 "<eps>"
+#define FST_FILLER              "exfiller"
+#define FST_END_UNIT            (0)     /* ends a command that is a prefix of another one */
+
+/* prefix tree of the commands, then minimized in place */
+struct fst_node {
+	int child;                  /* first child, children are sorted by unit */
+	int sibling;
+	int unit;                   /* unit of the arc into the node */
+	int olabel;                 /* command id output on the arc into the node, 0 if none */
+	int command;                /* command ending at the node, 0 if none */
+	int count;                  /* commands in the subtree */
+	int last;                   /* a command of the subtree */
+	int rep;                    /* equivalent node kept by minimization */
+	unsigned int hash;
+	int next;                   /* hash chain */
+	int state;                  /* state id of a kept node, -1 if not numbered */
+};
+
+struct fst_builder {
+	struct fst_node *nodes;
+	int num_nodes;
+	int max_nodes;
+};
+
+static void write_le16(uint8_t *p, unsigned int v)
+{
+	p[0] = (uint8_t)v;
+	p[1] = (uint8_t)(v >> 8);
+}
+
+static void write_le32(uint8_t *p, uint32_t v)
+{
+	p[0] = (uint8_t)v;
+	p[1] = (uint8_t)(v >> 8);
+	p[2] = (uint8_t)(v >> 16);
+	p[3] = (uint8_t)(v >> 24);
+}
+
+static unsigned int read_le16(const uint8_t *p)
+{
+	return (unsigned int)p[0] | ((unsigned int)p[1] << 8);
+}
+
+static uint32_t read_le32(const uint8_t *p)
+{
+	return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static unsigned int align_up(unsigned int n, unsigned int alignment)
+{
+	return (n + alignment - 1) / alignment * alignment;
+}
+
+static int is_separator(char c)
+{
+	return c == ' ' || c == '-' || c == '\t';
+}
+
+/* next unit of a pinyin string, 0 at the end, -1 when unknown */
+static int next_unit(const char **pinyin, const char *const *units, int num_units)
+{
+	const char *p = *pinyin;
+	while (*p && is_separator(*p)) {
+		p++;
+	}
+	const char *start = p;
+	while (*p && !is_separator(*p)) {
+		p++;
+	}
+	*pinyin = p;
+
+	size_t len = (size_t)(p - start);
+	if (len == 0) {
+		return 0;
+	}
+	for (int i = FST_END_UNIT + 1; i < num_units; i++) {
+		if (units[i] && strlen(units[i]) == len && memcmp(units[i], start, len) == 0) {
+			return i;
+		}
+	}
+	FST_LOGE("unknown unit %.*s\n", (int)len, start);
+	return -1;
+}
+
+static int new_node(struct fst_builder *b, int unit)
+{
+	struct fst_node *node = &b->nodes[b->num_nodes];
+	memset(node, 0, sizeof(*node));
+	node->child = -1;
+	node->sibling = -1;
+	node->unit = unit;
+	node->rep = b->num_nodes;
+	node->next = -1;
+	node->state = -1;
+	return b->num_nodes++;
+}
+
+/* child of parent on unit, created in unit order if missing */
+static int child_of(struct fst_builder *b, int parent, int unit)
+{
+	int *link = &b->nodes[parent].child;
+	while (*link >= 0 && b->nodes[*link].unit < unit) {
+		link = &b->nodes[*link].sibling;
+	}
+	if (*link >= 0 && b->nodes[*link].unit == unit) {
+		return *link;
+	}
+	int n = new_node(b, unit);
+	b->nodes[n].sibling = *link;
+	*link = n;
+	return n;
+}
+
+static int build_tree(struct fst_builder *b, const struct aivoice_fst_command *commands, int num,
+					  const char *const *units, int num_units)
+{
+	new_node(b, FST_END_UNIT);
+
+	for (int i = 0; i < num; i++) {
+		const char *p = commands[i].pinyin;
+		int node = 0;
+		int unit;
+		while ((unit = next_unit(&p, units, num_units)) > 0) {
+			node = child_of(b, node, unit);
+		}
+		if (unit < 0) {
+			return -1;
+		}
+		if (node == 0) {
+			FST_LOGE("command %d has no units\n", i + 1);
+			return -1;
+		}
+		if (b->nodes[node].command) {
+			FST_LOGE("commands %d and %d have the same pinyin\n", b->nodes[node].command, i + 1);
+			return -1;
+		}
+		b->nodes[node].command = i + 1;
+	}
+
+	// one final state: a command ending inside the tree moves to a child on the end unit
+	int tree_nodes = b->num_nodes;
+	for (int n = 1; n < tree_nodes; n++) {
+		if (b->nodes[n].command && b->nodes[n].child >= 0) {
+			int end = child_of(b, n, FST_END_UNIT);
+			b->nodes[end].command = b->nodes[n].command;
+			b->nodes[n].command = 0;
+		}
+	}
+	return 0;
+}
+
+/* output each command on the first arc where the prefix leads to it only */
+static void place_outputs(struct fst_builder *b)
+{
+	// children are created after their parent
+	for (int n = b->num_nodes - 1; n >= 0; n--) {
+		struct fst_node *node = &b->nodes[n];
+		node->count = node->command ? 1 : 0;
+		node->last = node->command;
+		for (int c = node->child; c >= 0; c = b->nodes[c].sibling) {
+			node->count += b->nodes[c].count;
+			node->last = b->nodes[c].last;
+		}
+	}
+	for (int n = 0; n < b->num_nodes; n++) {
+		const struct fst_node *node = &b->nodes[n];
+		for (int c = node->child; c >= 0; c = b->nodes[c].sibling) {
+			if (b->nodes[c].count == 1 && (n == 0 || node->count > 1)) {
+				b->nodes[c].olabel = b->nodes[c].last;
+			}
+		}
+	}
+}
+
+static int same_arcs(const struct fst_builder *b, int x, int y)
+{
+	int i = b->nodes[x].child;
+	int j = b->nodes[y].child;
+	for (; i >= 0 && j >= 0; i = b->nodes[i].sibling, j = b->nodes[j].sibling) {
+		const struct fst_node *u = &b->nodes[i];
+		const struct fst_node *v = &b->nodes[j];
+		if (u->unit != v->unit || u->olabel != v->olabel || u->rep != v->rep) {
+			return 0;
+		}
+	}
+	return i < 0 && j < 0;
+}
+
+/* merge nodes with the same arcs to the same nodes, children first */
+static int minimize(struct fst_builder *b)
+{
+	int num_buckets = 1;
+	while (num_buckets < 2 * b->num_nodes) {
+		num_buckets <<= 1;
+	}
+	int *buckets = (int *)rtk_aivoice_mem_alloc(num_buckets * sizeof(int), AIVOICE_MEMORY_CLASS_SCRATCH);
+	if (!buckets) {
+		FST_LOGE("malloc %d buckets failed\n", num_buckets);
+		return -1;
+	}
+	memset(buckets, 0xff, num_buckets * sizeof(int));
+
+	for (int n = b->num_nodes - 1; n >= 0; n--) {
+		struct fst_node *node = &b->nodes[n];
+		unsigned int hash = 2166136261u;
+		for (int c = node->child; c >= 0; c = b->nodes[c].sibling) {
+			hash = (hash ^ (unsigned int)b->nodes[c].unit) * 16777619u;
+			hash = (hash ^ (unsigned int)b->nodes[c].olabel) * 16777619u;
+			hash = (hash ^ (unsigned int)b->nodes[c].rep) * 16777619u;
+		}
+		node->hash = hash;
+
+		int *bucket = &buckets[hash & (num_buckets - 1)];
+		int m;
+		for (m = *bucket; m >= 0; m = b->nodes[m].next) {
+			if (b->nodes[m].hash == hash && same_arcs(b, m, n)) {
+				break;
+			}
+		}
+		if (m >= 0) {
+			node->rep = m;
+		} else {
+			node->next = *bucket;
+			*bucket = n;
+		}
+	}
+
+	rtk_aivoice_mem_free(buckets);
+	return 0;
+}
+
+/* number the kept nodes breadth first from the start, into order */
+static void number_states(struct fst_builder *b, int *order, int *num_states, int *num_arcs)
+{
+	int head = 0;
+	int tail = 0;
+
+	*num_arcs = 0;
+	b->nodes[0].state = tail;
+	order[tail++] = 0;
+	while (head < tail) {
+		const struct fst_node *node = &b->nodes[order[head++]];
+		for (int c = node->child; c >= 0; c = b->nodes[c].sibling) {
+			struct fst_node *dst = &b->nodes[b->nodes[c].rep];
+			if (dst->state < 0) {
+				dst->state = tail;
+				order[tail++] = b->nodes[c].rep;
+			}
+			(*num_arcs)++;
+		}
+	}
+	*num_states = tail;
+}
+
+/* the leaves of the tree are merged into one final state */
+static int final_state(const struct fst_builder *b, const int *order, int num_states)
+{
+	for (int s = 0; s < num_states; s++) {
+		if (b->nodes[order[s]].child < 0) {
+			return s;
+		}
+	}
+	return 0;
+}
+
+static int write_fst(const struct fst_builder *b, const int *order, int num_states, int num_arcs,
+					 const struct aivoice_fst_command *commands, int num, int num_units,
+					 uint8_t *out, unsigned int out_size)
+{
+	// symbols: <eps>, the commands, the filler
+	unsigned int num_symbols = (unsigned int)num + 2;
+	unsigned int symbols_size = 4 + 4 * num_symbols + sizeof(FST_EPS) + sizeof(FST_FILLER);
+	for (int i = 0; i < num; i++) {
+		symbols_size += strlen(commands[i].text) + 1;
+	}
+	unsigned int symbols_offset = FST_HEADER_LEN;
+	unsigned int graph_offset = align_up(symbols_offset + FST_SECTION_HEADER_LEN + symbols_size, FST_ALIGNMENT);
+	unsigned int graph_size = FST_GRAPH_HEADER_LEN + (unsigned int)num_arcs * FST_ARC_LEN;
+	unsigned int trailer_offset = align_up(graph_offset + FST_SECTION_HEADER_LEN + graph_size, FST_ALIGNMENT);
+	unsigned int size = trailer_offset + FST_TRAILER_LEN;
+
+	if (!out) {
+		return (int)size;
+	}
+	if (out_size < size) {
+		FST_LOGE("fst needs %u bytes, out has %u\n", size, out_size);
+		return -1;
+	}
+	memset(out, 0, size);
+
+	memcpy(out, FST_MAGIC, FST_MAGIC_LEN);
+	write_le32(out + FST_OFFSET_SIZE, size);
+	write_le32(out + FST_OFFSET_VERSION, FST_VERSION);
+	write_le32(out + FST_OFFSET_SECTIONS, 2);
+
+	uint8_t *p = out + symbols_offset;
+	write_le32(p, FST_SECTION_SYMBOLS);
+	write_le32(p + 4, symbols_size);
+	p += FST_SECTION_HEADER_LEN;
+	write_le32(p, num_symbols);
+	unsigned int offset = 4 + 4 * num_symbols;
+	for (unsigned int i = 0; i < num_symbols; i++) {
+		const char *symbol = i == 0 ? FST_EPS : i == num_symbols - 1 ? FST_FILLER : commands[i - 1].text;
+		unsigned int len = (unsigned int)strlen(symbol) + 1;
+		write_le32(p + 4 + 4 * i, offset);
+		memcpy(p + offset, symbol, len);
+		offset += len;
+	}
+
+	p = out + graph_offset;
+	write_le32(p, FST_SECTION_GRAPH);
+	write_le32(p + 4, graph_size);
+	p += FST_SECTION_HEADER_LEN;
+	write_le16(p + 2, (unsigned int)num_states);
+	write_le16(p + 4, (unsigned int)num_arcs);
+	write_le16(p + 6, (unsigned int)num_units);
+	write_le16(p + 8, (unsigned int)b->nodes[0].state);
+	write_le16(p + 10, (unsigned int)final_state(b, order, num_states));
+	write_le16(p + 12, num_symbols - 1);
+	p += FST_GRAPH_HEADER_LEN;
+
+	// arcs of each state in unit order
+	for (int s = 0; s < num_states; s++) {
+		const struct fst_node *node = &b->nodes[order[s]];
+		for (int c = node->child; c >= 0; c = b->nodes[c].sibling) {
+			write_le16(p, (unsigned int)s);
+			write_le16(p + 2, (unsigned int)b->nodes[b->nodes[c].rep].state);
+			write_le16(p + 4, (unsigned int)b->nodes[c].unit);
+			write_le16(p + 6, (unsigned int)b->nodes[c].olabel);
+			p += FST_ARC_LEN;
+		}
+	}
+
+	memcpy(out + trailer_offset, FST_TRAILER, FST_TRAILER_LEN);
+	return (int)size;
+}
+
+int rtk_aivoice_fst_compile(const struct aivoice_fst_command *commands, int num,
+							const char *const *units, int num_units, void *out, unsigned int out_size)
+{
+	if (!commands || num <= 0 || !units || num_units <= FST_END_UNIT + 1 || num_units > 65535) {
+		FST_LOGE("invalid commands or units\n");
+		return -1;
+	}
+	if (num + 1 > 65535) {
+		FST_LOGE("too many commands %d\n", num);
+		return -1;
+	}
+
+	// a node per unit of each command, an end node per command, and the start
+	struct fst_builder b = {0};
+	b.max_nodes = 1;
+	for (int i = 0; i < num; i++) {
+		if (!commands[i].pinyin || !commands[i].text) {
+			FST_LOGE("command %d has no pinyin or text\n", i + 1);
+			return -1;
+		}
+		const char *p = commands[i].pinyin;
+		int unit;
+		while ((unit = next_unit(&p, units, num_units)) > 0) {
+			b.max_nodes++;
+		}
+		if (unit < 0) {
+			return -1;
+		}
+		b.max_nodes++;
+	}
+
+	b.nodes = (struct fst_node *)rtk_aivoice_mem_alloc(b.max_nodes * sizeof(struct fst_node),
+			  AIVOICE_MEMORY_CLASS_SCRATCH);
+	int *order = (int *)rtk_aivoice_mem_alloc(b.max_nodes * sizeof(int), AIVOICE_MEMORY_CLASS_SCRATCH);
+	int ret = -1;
+	if (!b.nodes || !order) {
+		FST_LOGE("malloc %d nodes failed\n", b.max_nodes);
+		goto out;
+	}
+
+	if (build_tree(&b, commands, num, units, num_units) != 0) {
+		goto out;
+	}
+	place_outputs(&b);
+	if (minimize(&b) != 0) {
+		goto out;
+	}
+
+	int num_states;
+	int num_arcs;
+	number_states(&b, order, &num_states, &num_arcs);
+	if (num_states > AIVOICE_FST_MAX_STATES || num_arcs > AIVOICE_FST_MAX_ARCS) {
+		FST_LOGE("%d states and %d arcs exceed max %d and %d\n", num_states, num_arcs,
+				 AIVOICE_FST_MAX_STATES, AIVOICE_FST_MAX_ARCS);
+		goto out;
+	}
+	ret = write_fst(&b, order, num_states, num_arcs, commands, num, num_units, (uint8_t *)out, out_size);
+
+out:
+	rtk_aivoice_mem_free(order);
+	rtk_aivoice_mem_free(b.nodes);
+	return ret;
+}
+
+int rtk_aivoice_fst_get_info(const void *fst, struct aivoice_fst_info *info)
+{
+	const uint8_t *bin = (const uint8_t *)fst;
+
+	if (!bin || !info || memcmp(bin, FST_MAGIC, FST_MAGIC_LEN) != 0 ||
+		read_le32(bin + FST_OFFSET_VERSION) != FST_VERSION) {
+		FST_LOGE("invalid fst\n");
+		return -1;
+	}
+
+	uint32_t size = read_le32(bin + FST_OFFSET_SIZE);
+	uint32_t sections = read_le32(bin + FST_OFFSET_SECTIONS);
+	uint32_t offset = FST_HEADER_LEN;
+	int found = 0;
+
+	memset(info, 0, sizeof(*info));
+	for (uint32_t i = 0; i < sections && offset + FST_SECTION_HEADER_LEN <= size; i++) {
+		uint32_t type = read_le32(bin + offset);
+		uint32_t data_size = read_le32(bin + offset + 4);
+		const uint8_t *data = bin + offset + FST_SECTION_HEADER_LEN;
+		if (data_size > size - offset - FST_SECTION_HEADER_LEN) {
+			break;
+		}
+		if (type == FST_SECTION_SYMBOLS && data_size >= 4) {
+			// <eps> and the filler are not commands
+			info->num_commands = (int)read_le32(data) - 2;
+			found |= 1;
+		} else if (type == FST_SECTION_GRAPH && data_size >= FST_GRAPH_HEADER_LEN) {
+			info->num_states = (int)read_le16(data + 2);
+			info->num_arcs = (int)read_le16(data + 4);
+			info->num_units = (int)read_le16(data + 6);
+			found |= 2;
+		}
+		offset = align_up(offset + FST_SECTION_HEADER_LEN + data_size, FST_ALIGNMENT);
+	}
+
+	if (found != 3) {
+		FST_LOGE("fst has no symbols or graph\n");
+		return -1;
+	}
+	return 0;
+}
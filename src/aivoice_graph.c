@@ -0,0 +1,216 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "aivoice_plan.h"
+#include "aivoice_allocator.h"
+
+#define GR_LOGE(x, ...) printf("[AIVOICE] [GRAPH] error: " x, ##__VA_ARGS__)
+
+void aivoice_graph_init(struct aivoice_graph *graph)
+{
+	memset(graph, 0, sizeof(*graph));
+	graph->afe = -1;
+}
+
+struct aivoice_graph *rtk_aivoice_graph_create(void)
+{
+	struct aivoice_graph *graph = (struct aivoice_graph *)rtk_aivoice_mem_alloc(
+									  sizeof(*graph), AIVOICE_MEMORY_CLASS_STATE);
+	if (graph) {
+		aivoice_graph_init(graph);
+	}
+	return graph;
+}
+
+void rtk_aivoice_graph_destroy(struct aivoice_graph *graph)
+{
+	if (graph) {
+		rtk_aivoice_mem_free(graph->shards);
+	}
+	rtk_aivoice_mem_free(graph);
+}
+
+int rtk_aivoice_graph_add_node(struct aivoice_graph *graph, aivoice_node_type_e type,
+							   struct aivoice_config *config)
+{
+	if ((int)type < 0 || type >= AIVOICE_NODE_TYPE_NUM || (!config && type != AIVOICE_NODE_ENERGY)) {
+		GR_LOGE("invalid node type %d\n", (int)type);
+		return -1;
+	}
+	if (graph->num_nodes >= AIVOICE_GRAPH_MAX_NODES) {
+		GR_LOGE("too many nodes, max %d\n", AIVOICE_GRAPH_MAX_NODES);
+		return -1;
+	}
+	if (type == AIVOICE_NODE_AFE) {
+		if (graph->afe >= 0) {
+			GR_LOGE("only one afe node is supported\n");
+			return -1;
+		}
+		if (!config->afe) {
+			GR_LOGE("afe node requires afe config\n");
+			return -1;
+		}
+		graph->afe = graph->num_nodes;
+	}
+
+	struct aivoice_plan_node *node = &graph->nodes[graph->num_nodes];
+	node->type = type;
+	node->config = config;
+	node->audio_src = -1;
+	node->wake_gate = -1;
+	node->speech_gate = -1;
+
+	return graph->num_nodes++;
+}
+
+int rtk_aivoice_graph_add_keywords(struct aivoice_graph *graph, const struct aivoice_config *config,
+								   const char *const *keywords, const float *thresholds, int num_keywords,
+								   int *nodes, int max_nodes)
+{
+	if (!config || !keywords || num_keywords <= 0) {
+		GR_LOGE("invalid keywords\n");
+		return -1;
+	}
+
+	int num = (num_keywords + MAX_KWS_KEYWORD_NUMS - 1) / MAX_KWS_KEYWORD_NUMS;
+	if (graph->num_nodes + num > AIVOICE_GRAPH_MAX_NODES) {
+		GR_LOGE("%d keywords need %d kws nodes, %d nodes left\n", num_keywords, num,
+				AIVOICE_GRAPH_MAX_NODES - graph->num_nodes);
+		return -1;
+	}
+	if (nodes && max_nodes < num) {
+		GR_LOGE("%d keywords need %d kws nodes, nodes has %d\n", num_keywords, num, max_nodes);
+		return -1;
+	}
+
+	if (!graph->shards) {
+		graph->shards = (struct aivoice_plan_shard *)rtk_aivoice_mem_calloc(
+							AIVOICE_GRAPH_MAX_NODES * sizeof(*graph->shards), AIVOICE_MEMORY_CLASS_STATE);
+		if (!graph->shards) {
+			GR_LOGE("no memory for keyword configs\n");
+			return -1;
+		}
+	}
+
+	struct kws_config base = KWS_CONFIG_DEFAULT();
+	if (config->kws) {
+		base.sensitivity = config->kws->sensitivity;
+		base.mode = config->kws->mode;
+		base.enable_age_gender = config->kws->enable_age_gender;
+	}
+
+	for (int i = 0; i < num; i++) {
+		struct aivoice_plan_shard *shard = &graph->shards[graph->num_nodes];
+		struct kws_config *kws = &shard->kws;
+
+		memset(kws, 0, sizeof(*kws));
+		kws->sensitivity = base.sensitivity;
+		kws->mode = base.mode;
+		kws->enable_age_gender = base.enable_age_gender;
+		for (int k = 0; k < MAX_KWS_KEYWORD_NUMS && i * MAX_KWS_KEYWORD_NUMS + k < num_keywords; k++) {
+			kws->keywords[k] = keywords[i * MAX_KWS_KEYWORD_NUMS + k];
+			kws->thresholds[k] = thresholds ? thresholds[i * MAX_KWS_KEYWORD_NUMS + k] : 0.0f;
+		}
+		shard->config = *config;
+		shard->config.kws = kws;
+
+		int id = rtk_aivoice_graph_add_node(graph, AIVOICE_NODE_KWS, &shard->config);
+		if (graph->afe >= 0) {
+			rtk_aivoice_graph_connect(graph, graph->afe, id, AIVOICE_EDGE_AUDIO);
+		}
+		if (nodes) {
+			nodes[i] = id;
+		}
+	}
+
+	return num;
+}
+
+int rtk_aivoice_graph_connect(struct aivoice_graph *graph, int src, int dst, aivoice_edge_type_e edge)
+{
+	if (src < 0 || src >= graph->num_nodes || dst < 0 || dst >= graph->num_nodes || src == dst) {
+		GR_LOGE("invalid nodes %d -> %d\n", src, dst);
+		return -1;
+	}
+
+	struct aivoice_plan_node *s = &graph->nodes[src];
+	struct aivoice_plan_node *d = &graph->nodes[dst];
+	int *input;
+	aivoice_node_type_e src_type;
+
+	switch (edge) {
+	case AIVOICE_EDGE_AUDIO:
+		input = &d->audio_src;
+		src_type = AIVOICE_NODE_AFE;
+		break;
+	case AIVOICE_EDGE_WAKEUP_GATE:
+		input = &d->wake_gate;
+		src_type = AIVOICE_NODE_KWS;
+		break;
+	case AIVOICE_EDGE_SPEECH_GATE:
+		input = &d->speech_gate;
+		src_type = s->type == AIVOICE_NODE_ENERGY ? AIVOICE_NODE_ENERGY : AIVOICE_NODE_VAD;
+		break;
+	default:
+		GR_LOGE("invalid edge type %d\n", (int)edge);
+		return -1;
+	}
+
+	if (s->type != src_type || d->type == AIVOICE_NODE_AFE) {
+		GR_LOGE("edge %d can not connect node type %d -> %d\n", (int)edge, (int)s->type, (int)d->type);
+		return -1;
+	}
+	if (*input >= 0) {
+		GR_LOGE("node %d already has an input of edge type %d\n", dst, (int)edge);
+		return -1;
+	}
+
+	*input = src;
+	return 0;
+}
+
+int aivoice_graph_plan(struct aivoice_graph *graph)
+{
+	int placed[AIVOICE_GRAPH_MAX_NODES] = {0};
+	int num = 0;
+
+	for (int i = 0; i < graph->num_nodes; i++) {
+		const struct aivoice_plan_node *node = &graph->nodes[i];
+		if (node->type != AIVOICE_NODE_AFE && (node->audio_src >= 0) != (graph->afe >= 0)) {
+			GR_LOGE("node %d is not connected to afe\n", i);
+			return -1;
+		}
+	}
+
+	// gates run before the nodes they control
+	while (num < graph->num_nodes) {
+		int progress = 0;
+		for (int i = 0; i < graph->num_nodes; i++) {
+			const struct aivoice_plan_node *node = &graph->nodes[i];
+			if (placed[i] ||
+				(node->audio_src >= 0 && !placed[node->audio_src]) ||
+				(node->wake_gate >= 0 && !placed[node->wake_gate]) ||
+				(node->speech_gate >= 0 && !placed[node->speech_gate])) {
+				continue;
+			}
+			placed[i] = 1;
+			graph->order[num++] = i;
+			progress = 1;
+		}
+		if (!progress) {
+			GR_LOGE("graph has a gate loop\n");
+			return -1;
+		}
+	}
+
+	return 0;
+}
+
+struct aivoice_pipeline *rtk_aivoice_graph_compile(struct aivoice_graph *graph,
+		const struct aivoice_pipeline_config *pipeline_config)
+{
+	if (!graph || aivoice_graph_plan(graph) != 0) {
+		return NULL;
+	}
+	return aivoice_pipeline_create_plan(graph, pipeline_config);
+}
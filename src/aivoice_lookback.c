@@ -0,0 +1,222 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "aivoice_lookback.h"
+#include "aivoice_allocator.h"
+#include "aivoice_utils.h"
+
+#define LB_LOGE(x, ...) printf("[AIVOICE] [LOOKBACK] error: " x, ##__VA_ARGS__)
+
+#define SAMPLES_PER_MS  (AIVOICE_SAMPLE_RATE / 1000)
+
+struct aivoice_lookback {
+	struct aivoice_lookback_config config;
+	short *ring;
+	unsigned int capacity;                  /* samples */
+	volatile unsigned long long written;    /* samples since reset */
+	volatile unsigned long long reserved;   /* end of the samples being written, >= written */
+	volatile unsigned int seq;              /* odd while written or reserved is updated */
+	unsigned int vad_start_ms;
+};
+
+struct aivoice_lookback *rtk_aivoice_lookback_create(const struct aivoice_lookback_config *config)
+{
+	struct aivoice_lookback_config default_config = AIVOICE_LOOKBACK_CONFIG_DEFAULT();
+	if (!config) {
+		config = &default_config;
+	}
+
+	if (config->duration_ms < AIVOICE_FRAME_MS || config->keyword_window_ms < 0 || config->command_window_ms < 0) {
+		LB_LOGE("invalid duration %d ms\n", config->duration_ms);
+		return NULL;
+	}
+
+	struct aivoice_lookback *lookback = (struct aivoice_lookback *)rtk_aivoice_mem_calloc(
+											sizeof(*lookback), AIVOICE_MEMORY_CLASS_STATE);
+	if (!lookback) {
+		return NULL;
+	}
+
+	lookback->config = *config;
+	lookback->capacity = (unsigned int)config->duration_ms * SAMPLES_PER_MS;
+	lookback->ring = (short *)rtk_aivoice_mem_alloc(lookback->capacity * sizeof(short),
+					 AIVOICE_MEMORY_CLASS_STATE);
+	if (!lookback->ring) {
+		rtk_aivoice_mem_free(lookback);
+		return NULL;
+	}
+
+	return lookback;
+}
+
+void rtk_aivoice_lookback_destroy(struct aivoice_lookback *lookback)
+{
+	if (!lookback) {
+		return;
+	}
+
+	rtk_aivoice_mem_free(lookback->ring);
+	rtk_aivoice_mem_free(lookback);
+}
+
+// positions are 64 bit, readers on another thread could see half of an update
+static void set_positions(struct aivoice_lookback *lookback, unsigned long long written,
+						  unsigned long long reserved)
+{
+	lookback->seq++;
+	__sync_synchronize();
+	lookback->written = written;
+	lookback->reserved = reserved;
+	__sync_synchronize();
+	lookback->seq++;
+}
+
+static unsigned long long read_positions(struct aivoice_lookback *lookback, unsigned long long *reserved)
+{
+	unsigned int seq;
+	unsigned long long written;
+
+	do {
+		seq = lookback->seq;
+		__sync_synchronize();
+		written = lookback->written;
+		*reserved = lookback->reserved;
+		__sync_synchronize();
+	} while ((seq & 1) || seq != lookback->seq);
+
+	return written;
+}
+
+void rtk_aivoice_lookback_reset(struct aivoice_lookback *lookback)
+{
+	set_positions(lookback, 0, 0);
+	lookback->vad_start_ms = 0;
+}
+
+void rtk_aivoice_lookback_push(struct aivoice_lookback *lookback, const short *audio, int samples)
+{
+	unsigned long long written = lookback->written;
+
+	// the oldest samples are given up before they are overwritten
+	set_positions(lookback, written, written + (unsigned int)samples);
+
+	while (samples > 0) {
+		unsigned int pos = (unsigned int)(written % lookback->capacity);
+		unsigned int n = lookback->capacity - pos;
+		if (n > (unsigned int)samples) {
+			n = (unsigned int)samples;
+		}
+		memcpy(lookback->ring + pos, audio, n * sizeof(short));
+		audio += n;
+		samples -= (int)n;
+		written += n;
+	}
+
+	set_positions(lookback, written, written);
+}
+
+static int get_samples(struct aivoice_lookback *lookback, unsigned long long start, unsigned long long end,
+					   struct aivoice_audio_segment *segment)
+{
+	unsigned long long reserved;
+	unsigned long long written = read_positions(lookback, &reserved);
+	unsigned long long oldest = reserved > lookback->capacity ? reserved - lookback->capacity : 0;
+
+	memset(segment, 0, sizeof(*segment));
+	if (start < oldest) {
+		start = oldest;
+	}
+	if (end > written) {
+		end = written;
+	}
+	if (start >= end) {
+		return -1;
+	}
+
+	unsigned int pos = (unsigned int)(start % lookback->capacity);
+	unsigned int total = (unsigned int)(end - start);
+	unsigned int first = lookback->capacity - pos;
+	if (first > total) {
+		first = total;
+	}
+
+	segment->data[0] = lookback->ring + pos;
+	segment->samples[0] = (int)first;
+	if (first < total) {
+		segment->data[1] = lookback->ring;
+		segment->samples[1] = (int)(total - first);
+	}
+	segment->start_sample = start;
+	return 0;
+}
+
+int rtk_aivoice_lookback_get(struct aivoice_lookback *lookback, unsigned int start_ms, unsigned int end_ms,
+							 struct aivoice_audio_segment *segment)
+{
+	return get_samples(lookback, (unsigned long long)start_ms * SAMPLES_PER_MS,
+					   (unsigned long long)end_ms * SAMPLES_PER_MS, segment);
+}
+
+static unsigned int sub_ms(unsigned int a, int b)
+{
+	return a > (unsigned int)b ? a - (unsigned int)b : 0;
+}
+
+int rtk_aivoice_lookback_on_event(struct aivoice_lookback *lookback,
+								  enum aivoice_out_event_type event_type,
+								  const void *msg, int len,
+								  struct aivoice_audio_segment *segment)
+{
+	const struct aivoice_lookback_config *config = &lookback->config;
+	unsigned int now_ms = (unsigned int)(lookback->written / SAMPLES_PER_MS);
+	unsigned int start_ms;
+	unsigned int end_ms;
+
+	(void)len;
+	switch (event_type) {
+	case AIVOICE_EVOUT_AFE: {
+		const struct aivoice_evout_afe *afe_out = (const struct aivoice_evout_afe *)msg;
+		if (afe_out->data) {
+			rtk_aivoice_lookback_push(lookback, afe_out->data, AIVOICE_FRAME_SAMPLES);
+		}
+		return 0;
+	}
+
+	case AIVOICE_EVOUT_VAD: {
+		const struct aivoice_evout_vad *vad = (const struct aivoice_evout_vad *)msg;
+		if (vad->status == 1) {
+			lookback->vad_start_ms = vad->offset_ms;
+			start_ms = vad->offset_ms;
+			end_ms = now_ms;
+		} else {
+			start_ms = lookback->vad_start_ms;
+			end_ms = vad->offset_ms;
+		}
+		break;
+	}
+
+	case AIVOICE_EVOUT_WAKEUP:
+		start_ms = sub_ms(now_ms, config->keyword_window_ms);
+		end_ms = now_ms;
+		break;
+
+	case AIVOICE_EVOUT_ASR_RESULT:
+		start_ms = sub_ms(now_ms, config->command_window_ms);
+		end_ms = now_ms;
+		break;
+
+	default:
+		return 0;
+	}
+
+	return rtk_aivoice_lookback_get(lookback, start_ms, end_ms, segment) == 0;
+}
+
+int rtk_aivoice_lookback_segment_valid(struct aivoice_lookback *lookback,
+									   const struct aivoice_audio_segment *segment)
+{
+	unsigned long long reserved;
+
+	read_positions(lookback, &reserved);
+	return segment->start_sample + lookback->capacity >= reserved;
+}
@@ -0,0 +1,80 @@
+#include <string.h>
+#include <stdint.h>
+
+#include "aivoice_lz4.h"
+
+#define LZ4_MIN_MATCH   (4)
+
+/* read an extended length, returns -1 when input ends */
+static int read_length(const uint8_t **ip, const uint8_t *iend, size_t *len)
+{
+	unsigned int b;
+
+	do {
+		if (*ip >= iend) {
+			return -1;
+		}
+		b = *(*ip)++;
+		*len += b;
+	} while (b == 255);
+	return 0;
+}
+
+int aivoice_lz4_decode(const void *src, unsigned int src_len, void *dst, unsigned int dst_len)
+{
+	const uint8_t *ip = (const uint8_t *)src;
+	const uint8_t *iend = ip + src_len;
+	uint8_t *op = (uint8_t *)dst;
+	uint8_t *oend = op + dst_len;
+
+	while (ip < iend) {
+		unsigned int token = *ip++;
+
+		size_t literals = token >> 4;
+		if (literals == 15 && read_length(&ip, iend, &literals) != 0) {
+			return -1;
+		}
+		if (literals > (size_t)(iend - ip) || literals > (size_t)(oend - op)) {
+			return -1;
+		}
+		memcpy(op, ip, literals);
+		ip += literals;
+		op += literals;
+
+		// the last sequence has literals only
+		if (ip == iend) {
+			break;
+		}
+
+		if (iend - ip < 2) {
+			return -1;
+		}
+		size_t offset = (size_t)ip[0] | ((size_t)ip[1] << 8);
+		ip += 2;
+		if (offset == 0 || offset > (size_t)(op - (uint8_t *)dst)) {
+			return -1;
+		}
+
+		size_t match = token & 15;
+		if (match == 15 && read_length(&ip, iend, &match) != 0) {
+			return -1;
+		}
+		match += LZ4_MIN_MATCH;
+		if (match > (size_t)(oend - op)) {
+			return -1;
+		}
+
+		const uint8_t *ref = op - offset;
+		if (offset >= match) {
+			memcpy(op, ref, match);
+			op += match;
+		} else {
+			// overlapping copy repeats the last offset bytes
+			while (match--) {
+				*op++ = *ref++;
+			}
+		}
+	}
+
+	return op == oend ? 0 : -1;
+}
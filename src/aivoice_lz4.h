@@ -0,0 +1,16 @@
+#ifndef _AIVOICE_LZ4_H_
+#define _AIVOICE_LZ4_H_
+
+/*
+ * Decoder of lz4 blocks, used to load compressed resources,
+ * not part of the public api.
+ */
+
+/*
+ * Decode one lz4 block. Input is read once from start to end and output is
+ * written directly to dst, so src can be flash and dst the final buffer.
+ * Returns 0 when the block decodes to exactly dst_len bytes, -1 otherwise.
+ */
+int aivoice_lz4_decode(const void *src, unsigned int src_len, void *dst, unsigned int dst_len);
+
+#endif // _AIVOICE_LZ4_H_
@@ -0,0 +1,155 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "aivoice_memory.h"
+#include "aivoice_port.h"
+#include "aivoice_allocator.h"
+#include "aivoice_utils.h"
+
+#define MEM_LOGE(x, ...) printf("[AIVOICE] [MEM] error: " x, ##__VA_ARGS__)
+
+#define PROBE_FEED_FRAMES   (16)
+#define NO_AFE_FRAME_BYTES  AIVOICE_MONO_FRAME_BYTES   /* 16 ms mono audio */
+
+static unsigned int flow_modules(const struct rtk_aivoice_iface *iface)
+{
+	if (iface == &aivoice_iface_full_flow_v1) {
+		return (1 << AIVOICE_MEMORY_MODULE_AFE) | (1 << AIVOICE_MEMORY_MODULE_VAD) |
+			   (1 << AIVOICE_MEMORY_MODULE_KWS) | (1 << AIVOICE_MEMORY_MODULE_ASR);
+	} else if (iface == &aivoice_iface_afe_kws_vad_v1) {
+		return (1 << AIVOICE_MEMORY_MODULE_AFE) | (1 << AIVOICE_MEMORY_MODULE_VAD) |
+			   (1 << AIVOICE_MEMORY_MODULE_KWS);
+	} else if (iface == &aivoice_iface_afe_kws_v1) {
+		return (1 << AIVOICE_MEMORY_MODULE_AFE) | (1 << AIVOICE_MEMORY_MODULE_KWS);
+	} else if (iface == &aivoice_iface_afe_v1) {
+		return 1 << AIVOICE_MEMORY_MODULE_AFE;
+	} else if (iface == &aivoice_iface_vad_v1) {
+		return 1 << AIVOICE_MEMORY_MODULE_VAD;
+	} else if (iface == &aivoice_iface_kws_v1) {
+		return 1 << AIVOICE_MEMORY_MODULE_KWS;
+	} else if (iface == &aivoice_iface_asr_v1) {
+		return 1 << AIVOICE_MEMORY_MODULE_ASR;
+	}
+	return 0;
+}
+
+static const struct rtk_aivoice_iface *module_iface(int module)
+{
+	switch (module) {
+	case AIVOICE_MEMORY_MODULE_AFE:
+		return &aivoice_iface_afe_v1;
+	case AIVOICE_MEMORY_MODULE_VAD:
+		return &aivoice_iface_vad_v1;
+	case AIVOICE_MEMORY_MODULE_KWS:
+		return &aivoice_iface_kws_v1;
+	case AIVOICE_MEMORY_MODULE_ASR:
+		return &aivoice_iface_asr_v1;
+	default:
+		return NULL;
+	}
+}
+
+static int null_callback(void *user_data, enum aivoice_out_event_type event_type,
+						 const void *msg, int len)
+{
+	(void)user_data;
+	(void)event_type;
+	(void)msg;
+	(void)len;
+	return 0;
+}
+
+static void sample(const long base[], long peak[])
+{
+	for (int r = 0; r < AIVOICE_MEMORY_REGION_NUM; r++) {
+		long used = aivoice_port_heap_usage(r) - base[r];
+		if (used > peak[r]) {
+			peak[r] = used;
+		}
+	}
+}
+
+static int probe(const struct rtk_aivoice_iface *iface, struct aivoice_config *config,
+				 char *frame, int frame_bytes, struct aivoice_memory_usage usage[])
+{
+	long base[AIVOICE_MEMORY_REGION_NUM];
+	long persistent[AIVOICE_MEMORY_REGION_NUM];
+	long peak[AIVOICE_MEMORY_REGION_NUM] = {0};
+
+	for (int r = 0; r < AIVOICE_MEMORY_REGION_NUM; r++) {
+		base[r] = aivoice_port_heap_usage(r);
+	}
+
+	void *handle = iface->create(config);
+	if (!handle) {
+		return -1;
+	}
+	rtk_aivoice_register_callback(handle, null_callback, NULL);
+
+	for (int r = 0; r < AIVOICE_MEMORY_REGION_NUM; r++) {
+		persistent[r] = aivoice_port_heap_usage(r) - base[r];
+		if (persistent[r] > peak[r]) {
+			peak[r] = persistent[r];
+		}
+	}
+
+	for (int i = 0; i < PROBE_FEED_FRAMES; i++) {
+		iface->feed(handle, frame, frame_bytes);
+		sample(base, peak);
+	}
+
+	iface->destroy(handle);
+
+	for (int r = 0; r < AIVOICE_MEMORY_REGION_NUM; r++) {
+		usage[r].persistent = persistent[r] > 0 ? (unsigned int)persistent[r] : 0;
+		usage[r].peak = peak[r] > 0 ? (unsigned int)peak[r] : 0;
+		usage[r].scratch = usage[r].peak - usage[r].persistent;
+	}
+	return 0;
+}
+
+int rtk_aivoice_query_memory(const struct rtk_aivoice_iface *iface,
+							 struct aivoice_config *config,
+							 struct aivoice_memory_report *report)
+{
+	if (!iface || !config || !report) {
+		return -1;
+	}
+
+	memset(report, 0, sizeof(*report));
+	report->module_mask = flow_modules(iface);
+
+	// vad_v1, kws_v1 and asr_v1 take mono audio and do not read config->afe
+	int with_afe = (report->module_mask & (1 << AIVOICE_MEMORY_MODULE_AFE)) || !report->module_mask;
+	if (with_afe && !config->afe) {
+		MEM_LOGE("flow with afe needs config->afe\n");
+		return -1;
+	}
+
+	int afe_bytes = with_afe ? aivoice_afe_frame_bytes(config->afe) : 0;
+	int max_bytes = afe_bytes > (int)NO_AFE_FRAME_BYTES ? afe_bytes : (int)NO_AFE_FRAME_BYTES;
+	char *frame = (char *)rtk_aivoice_mem_calloc((size_t)max_bytes, AIVOICE_MEMORY_CLASS_SCRATCH);
+	if (!frame) {
+		return -1;
+	}
+
+	int ret = probe(iface, config, frame, with_afe ? afe_bytes : (int)NO_AFE_FRAME_BYTES, report->total);
+	if (ret != 0) {
+		MEM_LOGE("create flow failed\n");
+	}
+
+	for (int m = 0; m < AIVOICE_MEMORY_MODULE_NUM && ret == 0; m++) {
+		if (!(report->module_mask & (1 << m))) {
+			continue;
+		}
+		ret = probe(module_iface(m), config, frame,
+					m == AIVOICE_MEMORY_MODULE_AFE ? afe_bytes : (int)NO_AFE_FRAME_BYTES,
+					report->modules[m]);
+		if (ret != 0) {
+			MEM_LOGE("create module %d failed\n", m);
+		}
+	}
+
+	rtk_aivoice_mem_free(frame);
+	return ret;
+}
@@ -0,0 +1,1472 @@
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "aivoice_pipeline.h"
+#include "aivoice_allocator.h"
+#include "aivoice_resource.h"
+#include "aivoice_port.h"
+#include "aivoice_utils.h"
+#include "aivoice_plan.h"
+#include "aivoice_warmup.h"
+
+#define PL_LOGE(x, ...) printf("[AIVOICE] [PIPELINE] error: " x, ##__VA_ARGS__)
+
+#define rmb()  __sync_synchronize()
+#define wmb()  __sync_synchronize()
+#define mb()   __sync_synchronize()
+
+#define AFE_JSON_MAX_LEN    (128)   /* out_others_json kept for each queued frame */
+
+#define ENERGY_MIN_FLOOR    (100.0f)    /* mean square, about -70 dBFS */
+#define ENERGY_FLOOR_DOWN   (0.5f)      /* noise floor follows quiet frames fast */
+#define ENERGY_FLOOR_UP     (0.002f)    /* and louder frames slowly, about 8 s */
+
+#define COST_AVG_FRAMES     (8)         /* feed cost is averaged over about this many frames */
+
+struct frame_slot {
+	uint32_t gen;                   /* reset generation the frame belongs to */
+	int ch_num;
+	short *audio;
+	char json[AFE_JSON_MAX_LEN];
+};
+
+/* copy of an aivoice_config and the module configs it points to */
+struct node_config {
+	struct aivoice_config config;
+	struct afe_config afe;
+	struct vad_config vad;
+	struct kws_config kws;
+	struct asr_config asr;
+	struct aivoice_sdk_config common;
+};
+
+struct node {
+	struct aivoice_pipeline *pipeline;
+	aivoice_node_type_e type;
+	const struct rtk_aivoice_iface *iface;
+	aivoice_callback_handler cb;    /* callback of the node, NULL to use the pipeline callback */
+	void *cb_user_data;
+	struct aivoice_config *config;  /* config the module is created with */
+	struct node_config cfg;         /* config of the node, owned by the node */
+	void *handle;
+
+	/* update, prepared by rtk_aivoice_pipeline_update_config, applied between two frames */
+	struct node_config next_cfg;
+	void *next_handle;              /* new instance, NULL to keep the instance */
+	int next_recreate;              /* lazy node: recreate the instance with next_cfg */
+	volatile int update_pending;
+	struct aivoice_resource *next_res;  /* model swap: resource of the new instance */
+	struct aivoice_resource *res;       /* model swap: resource the node holds, NULL if none */
+	int loading;                    /* staged start: waits for rtk_aivoice_pipeline_load_models */
+
+	int wake_gate;                  /* KWS node gating this node, -1 if none */
+	int speech_gate;                /* VAD or ENERGY node gating this node, -1 if none */
+	int active;                     /* runs in the current frame */
+	unsigned int skipped;           /* frames skipped in a row by the speech gate */
+
+	/* KWS node */
+	int gates_nodes;                /* KWS pauses during its session */
+	int gates_asr;                  /* ASR_REC_TIMEOUT is sent when its session ends */
+	int awake;
+	unsigned int deadline;
+	unsigned int timeout_frames;
+
+	/* VAD and ENERGY node */
+	int in_speech;
+	unsigned int start_frame;       /* frame the instance started at, vad offset_ms counts from it */
+
+	/* ENERGY node */
+	float noise_floor;
+	unsigned int hangover;          /* frames left before the gate closes */
+
+	/* lazy ASR node */
+	int lazy;
+	int release_pending;
+	unsigned int release_at;
+};
+
+struct aivoice_pipeline {
+	struct aivoice_pipeline_config pipeline_config;
+
+	struct node nodes[AIVOICE_GRAPH_MAX_NODES];
+	int order[AIVOICE_GRAPH_MAX_NODES];
+	int num_nodes;
+	int loading_nodes;              /* staged start: nodes not loaded yet */
+	struct node *afe;
+
+	aivoice_callback_handler cb;
+	void *cb_user_data;
+
+	/* recognition state, owned by the thread running recognition */
+	unsigned int frame_index;
+	uint32_t worker_gen;
+
+	/* last frames of channel 0, fed to speech gated nodes when the gate opens,
+	   and to nodes of staged start when they are loaded */
+	short *history;
+	unsigned int history_frames;
+	unsigned int history_count;
+	unsigned int history_pos;
+	float gate_ratio;
+	unsigned int hangover_frames;
+
+	/* quality adaption, owned by the thread calling feed */
+	const struct aivoice_config *base_config;  /* config of AFE node at full quality */
+	struct aivoice_config quality_config;       /* config of AFE node in use */
+	struct afe_config quality_afe;
+	int quality_level;
+	long long cost_avg_us;
+	int cost_seeded;
+	unsigned int over_frames;
+	unsigned int under_frames;
+	long long wait_us;                          /* time the current feed waited for queue space */
+	aivoice_quality_callback quality_cb;
+	void *quality_cb_user_data;
+
+	/* quality step, requested by feed and built off the feed thread by rtk_aivoice_pipeline_adapt_quality */
+	volatile int quality_target;                /* level requested, -1 if none */
+	int quality_next;                           /* level of the AFE instance pending in the AFE node, -1 if none */
+	struct aivoice_config quality_next_config;
+	struct afe_config quality_next_afe;
+	volatile int update_lock;                   /* held while new instances are built */
+
+	/* frame queue, threaded mode only */
+	struct frame_slot *slots;
+	short *audio;
+	uint32_t capacity;
+	uint32_t mask;
+	int max_ch;
+	void *frame_sem;
+	void *space_sem;
+
+	/* written by producer only */
+	volatile uint32_t head;
+	volatile uint32_t gen;
+	volatile int feed_waiting;
+
+	/* written by consumer only */
+	volatile uint32_t tail;
+
+	volatile int stopped;
+
+	struct aivoice_pipeline_stats stats;
+};
+
+static const struct rtk_aivoice_iface *const node_ifaces[AIVOICE_NODE_TYPE_NUM] = {
+	[AIVOICE_NODE_AFE] = &aivoice_iface_afe_v1,
+	[AIVOICE_NODE_VAD] = &aivoice_iface_vad_v1,
+	[AIVOICE_NODE_KWS] = &aivoice_iface_kws_v1,
+	[AIVOICE_NODE_ASR] = &aivoice_iface_asr_v1,
+};
+
+static int is_power_of_2(int n)
+{
+	return n > 0 && (n & (n - 1)) == 0;
+}
+
+static int emit(struct aivoice_pipeline *pipeline, enum aivoice_out_event_type event_type,
+				const void *msg, int len)
+{
+	if (pipeline->cb) {
+		return pipeline->cb(pipeline->cb_user_data, event_type, msg, len);
+	}
+	return 0;
+}
+
+/* events of a node go to its own callback when it has one */
+static int emit_node(struct node *node, enum aivoice_out_event_type event_type, const void *msg, int len)
+{
+	if (node->cb) {
+		return node->cb(node->cb_user_data, event_type, msg, len);
+	}
+	return emit(node->pipeline, event_type, msg, len);
+}
+
+static int afe_callback(void *user_data, enum aivoice_out_event_type event_type,
+						const void *msg, int len);
+static int node_callback(void *user_data, enum aivoice_out_event_type event_type,
+						 const void *msg, int len);
+static void quality_changed(struct aivoice_pipeline *pipeline, int level);
+
+static void node_config_set(struct node_config *dst, const struct aivoice_config *src)
+{
+	dst->config = *src;
+	if (src->afe) {
+		dst->afe = *src->afe;
+		dst->config.afe = &dst->afe;
+	}
+	if (src->vad) {
+		dst->vad = *src->vad;
+		dst->config.vad = &dst->vad;
+	}
+	if (src->kws) {
+		dst->kws = *src->kws;
+		dst->config.kws = &dst->kws;
+	}
+	if (src->asr) {
+		dst->asr = *src->asr;
+		dst->config.asr = &dst->asr;
+	}
+	if (src->common) {
+		dst->common = *src->common;
+		dst->config.common = &dst->common;
+	}
+}
+
+static unsigned int session_frames(const struct aivoice_config *config)
+{
+	return (unsigned int)(config && config->common ? config->common->timeout : 10) * 1000 / AIVOICE_FRAME_MS;
+}
+
+static int create_node(struct node *node)
+{
+	if (!node->iface) {
+		return 0;
+	}
+	node->handle = node->iface->create(node->config);
+	if (!node->handle) {
+		PL_LOGE("create node %d failed\n", (int)(node - node->pipeline->nodes));
+		return -1;
+	}
+	if (node->type == AIVOICE_NODE_AFE) {
+		rtk_aivoice_register_callback(node->handle, afe_callback, node->pipeline);
+	} else {
+		rtk_aivoice_register_callback(node->handle, node_callback, node);
+	}
+	return 0;
+}
+
+static void destroy_node(struct node *node)
+{
+	if (node->handle) {
+		node->iface->destroy(node->handle);
+		node->handle = NULL;
+	}
+}
+
+static void acquire_lazy(struct node *node)
+{
+	struct aivoice_pipeline *pipeline = node->pipeline;
+
+	node->release_pending = 0;
+	if (node->handle) {
+		return;
+	}
+
+	long long start_us = aivoice_port_time_us();
+	if (create_node(node) == 0) {
+		unsigned int cost_us = (unsigned int)(aivoice_port_time_us() - start_us);
+		pipeline->stats.asr_creates++;
+		if (cost_us > pipeline->stats.asr_create_us_max) {
+			pipeline->stats.asr_create_us_max = cost_us;
+		}
+	}
+}
+
+static void reset_recognition(struct aivoice_pipeline *pipeline)
+{
+	for (int i = 0; i < pipeline->num_nodes; i++) {
+		struct node *node = &pipeline->nodes[i];
+		if (node->type == AIVOICE_NODE_AFE) {
+			continue;
+		}
+		if (node->lazy) {
+			destroy_node(node);
+			node->release_pending = 0;
+		}
+		if (node->handle) {
+			node->iface->reset(node->handle);
+		}
+		node->awake = 0;
+		node->in_speech = 0;
+		node->skipped = 0;
+		node->noise_floor = 0.0f;
+		node->hangover = 0;
+		node->start_frame = 0;
+	}
+	pipeline->frame_index = 0;
+	pipeline->history_count = 0;
+}
+
+/* switch to the prepared update, in the thread running the node, between two frames */
+static void apply_update(struct node *node)
+{
+	struct aivoice_pipeline *pipeline = node->pipeline;
+	void *old = NULL;
+	int quality = node->type == AIVOICE_NODE_AFE ? pipeline->quality_next : -1;
+
+	rmb();
+	if (quality >= 0) {
+		// a quality step only changes the instance, the node keeps its config
+		pipeline->quality_afe = pipeline->quality_next_afe;
+		pipeline->quality_next = -1;
+	} else {
+		node_config_set(&node->cfg, &node->next_cfg.config);
+		node->timeout_frames = session_frames(&node->cfg.config);
+	}
+
+	if (node->type == AIVOICE_NODE_AFE && quality < 0) {
+		// a new AFE config restarts quality adaption from full quality
+		pipeline->quality_config = node->cfg.config;
+		pipeline->quality_afe = node->cfg.afe;
+		pipeline->quality_config.afe = &pipeline->quality_afe;
+		pipeline->quality_level = 0;
+		pipeline->stats.quality_level = 0;
+		pipeline->cost_seeded = 0;
+		pipeline->quality_target = -1;
+	}
+
+	struct aivoice_resource *old_res = NULL;
+	if (node->next_res) {
+		old_res = node->res;
+		node->res = node->next_res;
+		node->next_res = NULL;
+	}
+
+	if (node->next_handle) {
+		old = node->handle;
+		node->handle = node->next_handle;
+		node->next_handle = NULL;
+		// a staged node gets its skipped frames as preroll
+		node->start_frame = pipeline->frame_index -
+							(node->skipped < pipeline->history_count ? node->skipped : pipeline->history_count);
+	} else if (node->next_recreate && node->handle) {
+		old = node->handle;
+		node->handle = NULL;
+	}
+	node->next_recreate = 0;
+	if (node->loading) {
+		node->loading = 0;
+		pipeline->loading_nodes--;
+	}
+
+	mb();
+	node->update_pending = 0;
+
+	if (old) {
+		node->iface->destroy(old);
+	}
+	// the old model is released after the instance using it
+	rtk_aivoice_resource_close(old_res);
+	if (quality >= 0) {
+		quality_changed(pipeline, quality);
+	}
+	if (node->lazy && !node->handle && node->wake_gate >= 0 && pipeline->nodes[node->wake_gate].awake) {
+		acquire_lazy(node);
+	}
+}
+
+static void start_session(struct node *kws)
+{
+	struct aivoice_pipeline *pipeline = kws->pipeline;
+	int index = (int)(kws - pipeline->nodes);
+
+	// a new session starts from the next frame
+	for (int i = 0; i < pipeline->num_nodes; i++) {
+		struct node *node = &pipeline->nodes[i];
+		if (node->wake_gate != index) {
+			continue;
+		}
+		if (node->lazy) {
+			acquire_lazy(node);
+		}
+		if (node->handle) {
+			node->iface->reset(node->handle);
+		}
+		node->start_frame = pipeline->frame_index + 1;
+	}
+	kws->awake = 1;
+	kws->deadline = pipeline->frame_index + kws->timeout_frames;
+}
+
+static void end_session(struct node *kws)
+{
+	struct aivoice_pipeline *pipeline = kws->pipeline;
+	int index = (int)(kws - pipeline->nodes);
+
+	kws->awake = 0;
+	kws->iface->reset(kws->handle);
+	if (kws->gates_asr) {
+		emit_node(kws, AIVOICE_EVOUT_ASR_REC_TIMEOUT, NULL, 0);
+	}
+
+	for (int i = 0; i < pipeline->num_nodes; i++) {
+		struct node *node = &pipeline->nodes[i];
+		if (node->wake_gate == index && node->lazy) {
+			node->release_pending = 1;
+			node->release_at = pipeline->frame_index +
+							   (unsigned int)pipeline->pipeline_config.asr_linger_ms / AIVOICE_FRAME_MS;
+		}
+	}
+}
+
+static int node_callback(void *user_data, enum aivoice_out_event_type event_type,
+						 const void *msg, int len)
+{
+	struct node *node = (struct node *)user_data;
+	struct aivoice_pipeline *pipeline = node->pipeline;
+	struct aivoice_evout_vad vad;
+
+	switch (event_type) {
+	case AIVOICE_EVOUT_WAKEUP:
+		if (node->type == AIVOICE_NODE_KWS && node->gates_nodes) {
+			start_session(node);
+		}
+		break;
+	case AIVOICE_EVOUT_ASR_RESULT:
+		if (node->wake_gate >= 0) {
+			struct node *kws = &pipeline->nodes[node->wake_gate];
+			kws->deadline = pipeline->frame_index + kws->timeout_frames;
+		}
+		break;
+	case AIVOICE_EVOUT_VAD:
+		if (node->type == AIVOICE_NODE_VAD) {
+			// offsets of a reset or replaced instance are rebased to the stream, as lookback expects
+			memcpy(&vad, msg, sizeof(vad));
+			vad.offset_ms += node->start_frame * AIVOICE_FRAME_MS;
+			node->in_speech = vad.status;
+			msg = &vad;
+		}
+		break;
+	default:
+		break;
+	}
+
+	return emit_node(node, event_type, msg, len);
+}
+
+/* whether node runs in this frame, regardless of its speech gate */
+static int node_is_enabled(struct aivoice_pipeline *pipeline, struct node *node)
+{
+	if (node->type == AIVOICE_NODE_KWS && node->gates_nodes && node->awake) {
+		return 0;
+	}
+	if (node->wake_gate >= 0 && !pipeline->nodes[node->wake_gate].awake) {
+		return 0;
+	}
+	return 1;
+}
+
+static int speech_gate_open(struct aivoice_pipeline *pipeline, struct node *node)
+{
+	struct node *gate = &pipeline->nodes[node->speech_gate];
+	return gate->active && gate->in_speech;
+}
+
+/* energy detector: mean square of the frame against an adaptive noise floor */
+static void feed_energy(struct aivoice_pipeline *pipeline, struct node *node, const short *audio)
+{
+	float energy = 0.0f;
+	for (int i = 0; i < AIVOICE_FRAME_SAMPLES; i++) {
+		energy += (float)audio[i] * audio[i];
+	}
+	energy /= AIVOICE_FRAME_SAMPLES;
+
+	if (node->noise_floor <= 0.0f) {
+		node->noise_floor = energy;
+	} else if (energy < node->noise_floor) {
+		node->noise_floor += (energy - node->noise_floor) * ENERGY_FLOOR_DOWN;
+	} else {
+		node->noise_floor += (energy - node->noise_floor) * ENERGY_FLOOR_UP;
+	}
+	if (node->noise_floor < ENERGY_MIN_FLOOR) {
+		node->noise_floor = ENERGY_MIN_FLOOR;
+	}
+
+	if (energy > node->noise_floor * pipeline->gate_ratio) {
+		node->hangover = pipeline->hangover_frames + 1;
+	} else if (node->hangover > 0) {
+		node->hangover--;
+	}
+	node->in_speech = node->hangover > 0;
+}
+
+/* feed the frames a speech gated node skipped, at most history_frames, oldest first */
+static void feed_preroll(struct aivoice_pipeline *pipeline, struct node *node)
+{
+	unsigned int n = node->skipped;
+	if (n > pipeline->history_count) {
+		n = pipeline->history_count;
+	}
+	for (unsigned int i = n; i > 0; i--) {
+		unsigned int pos = (pipeline->history_pos + pipeline->history_frames - i) % pipeline->history_frames;
+		node->iface->feed(node->handle, (char *)(pipeline->history + pos * AIVOICE_FRAME_SAMPLES),
+						  AIVOICE_MONO_FRAME_BYTES);
+	}
+}
+
+static void push_history(struct aivoice_pipeline *pipeline, const short *audio)
+{
+	memcpy(pipeline->history + pipeline->history_pos * AIVOICE_FRAME_SAMPLES, audio, AIVOICE_MONO_FRAME_BYTES);
+	pipeline->history_pos = (pipeline->history_pos + 1) % pipeline->history_frames;
+	if (pipeline->history_count < pipeline->history_frames) {
+		pipeline->history_count++;
+	}
+}
+
+static void process_frame(struct aivoice_pipeline *pipeline, int ch_num, short *audio, char *json)
+{
+	for (int i = 0; i < pipeline->num_nodes; i++) {
+		struct node *node = &pipeline->nodes[i];
+		if (node->update_pending && node->type != AIVOICE_NODE_AFE) {
+			apply_update(node);
+		}
+	}
+
+	if (pipeline->afe) {
+		struct aivoice_evout_afe afe_out = {
+			.ch_num = ch_num,
+			.data = audio,
+			.out_others_json = json,
+		};
+		emit(pipeline, AIVOICE_EVOUT_AFE, &afe_out, sizeof(afe_out));
+	}
+
+	// gates are sampled before any node runs, they take effect from the next frame
+	for (int i = 0; i < pipeline->num_nodes; i++) {
+		struct node *node = &pipeline->nodes[pipeline->order[i]];
+		if (node->type == AIVOICE_NODE_AFE) {
+			continue;
+		}
+		node->active = node_is_enabled(pipeline, node);
+		if (node->active && node->speech_gate >= 0) {
+			pipeline->stats.gated_frames++;
+			node->active = speech_gate_open(pipeline, node);
+			if (!node->active) {
+				node->skipped++;
+				pipeline->stats.skipped_frames++;
+			}
+		} else if (!node->active) {
+			node->skipped = 0;
+		}
+		if ((node->type == AIVOICE_NODE_VAD || node->type == AIVOICE_NODE_ENERGY) && !node->active) {
+			node->in_speech = 0;
+			node->hangover = 0;
+		}
+	}
+
+	for (int i = 0; i < pipeline->num_nodes; i++) {
+		struct node *node = &pipeline->nodes[pipeline->order[i]];
+		if (node->type == AIVOICE_NODE_AFE || !node->active) {
+			continue;
+		}
+		if (node->type == AIVOICE_NODE_ENERGY) {
+			feed_energy(pipeline, node, audio);
+			continue;
+		}
+		if (!node->handle) {
+			// staged start: the frames are fed as preroll when the node is loaded
+			if (node->loading) {
+				node->skipped++;
+			}
+			continue;
+		}
+		if (node->skipped) {
+			feed_preroll(pipeline, node);
+			node->skipped = 0;
+		}
+		node->iface->feed(node->handle, (char *)audio, AIVOICE_MONO_FRAME_BYTES);
+	}
+
+	if (pipeline->history) {
+		push_history(pipeline, audio);
+	}
+
+	pipeline->frame_index++;
+	pipeline->stats.processed_frames++;
+	if (pipeline->loading_nodes > 0) {
+		pipeline->stats.load_frames++;
+	}
+
+	for (int i = 0; i < pipeline->num_nodes; i++) {
+		struct node *node = &pipeline->nodes[i];
+		if (node->awake && (int)(pipeline->frame_index - node->deadline) >= 0) {
+			end_session(node);
+		}
+		if (node->release_pending && (int)(pipeline->frame_index - node->release_at) >= 0) {
+			destroy_node(node);
+			node->release_pending = 0;
+		}
+	}
+}
+
+/* wait until the queue has a free slot, at most feed_timeout_ms */
+static int wait_for_space(struct aivoice_pipeline *pipeline, uint32_t head)
+{
+	int timeout_ms = pipeline->pipeline_config.feed_timeout_ms;
+	long long end_us = aivoice_port_time_us() + (long long)timeout_ms * 1000;
+
+	while (head - pipeline->tail >= pipeline->capacity) {
+		int wait_ms = -1;
+		if (timeout_ms >= 0) {
+			long long left_us = end_us - aivoice_port_time_us();
+			if (left_us <= 0) {
+				return -1;
+			}
+			wait_ms = (int)((left_us + 999) / 1000);
+		}
+
+		pipeline->feed_waiting = 1;
+		mb();
+		if (head - pipeline->tail >= pipeline->capacity) {
+			long long start_us = aivoice_port_time_us();
+			aivoice_port_sem_take(pipeline->space_sem, wait_ms);
+			pipeline->wait_us += aivoice_port_time_us() - start_us;
+		}
+		pipeline->feed_waiting = 0;
+	}
+	return 0;
+}
+
+/* hand one frame of AFE output (or input without AFE) to recognition */
+static int submit_frame(struct aivoice_pipeline *pipeline, int ch_num, short *audio, char *json)
+{
+	pipeline->stats.fed_frames++;
+
+	if (!pipeline->pipeline_config.threaded) {
+		process_frame(pipeline, ch_num, audio, json);
+		return 0;
+	}
+
+	uint32_t head = pipeline->head;
+	if (wait_for_space(pipeline, head) != 0) {
+		pipeline->stats.dropped_frames++;
+		return -1;
+	}
+
+	struct frame_slot *slot = &pipeline->slots[head & pipeline->mask];
+	if (ch_num > pipeline->max_ch) {
+		ch_num = pipeline->max_ch;
+	}
+
+	slot->gen = pipeline->gen;
+	slot->ch_num = ch_num;
+	memcpy(slot->audio, audio, (size_t)ch_num * AIVOICE_MONO_FRAME_BYTES);
+	if (json) {
+		strncpy(slot->json, json, AFE_JSON_MAX_LEN - 1);
+		slot->json[AFE_JSON_MAX_LEN - 1] = '\0';
+	} else {
+		slot->json[0] = '\0';
+	}
+
+	wmb();
+	pipeline->head = head + 1;
+	aivoice_port_sem_give(pipeline->frame_sem);
+
+	uint32_t used = head + 1 - pipeline->tail;
+	if (used > pipeline->stats.high_watermark) {
+		pipeline->stats.high_watermark = used;
+	}
+
+	return 0;
+}
+
+static int afe_callback(void *user_data, enum aivoice_out_event_type event_type,
+						const void *msg, int len)
+{
+	struct aivoice_pipeline *pipeline = (struct aivoice_pipeline *)user_data;
+
+	if (event_type != AIVOICE_EVOUT_AFE) {
+		return emit(pipeline, event_type, msg, len);
+	}
+
+	const struct aivoice_evout_afe *afe_out = (const struct aivoice_evout_afe *)msg;
+	return submit_frame(pipeline, afe_out->ch_num, afe_out->data, afe_out->out_others_json);
+}
+
+/* afe configuration of a quality level, each level adds its step to the ones above */
+static void quality_afe_config(const struct afe_config *base, int level, struct afe_config *afe)
+{
+	*afe = *base;
+	if (level >= AIVOICE_QUALITY_AEC_MID && afe->aec_cost > AFE_AEC_FILTER_MID) {
+		afe->aec_cost = AFE_AEC_FILTER_MID;
+	}
+	if (level >= AIVOICE_QUALITY_AEC_LOW) {
+		afe->aec_cost = AFE_AEC_FILTER_LOW;
+	}
+	if (level >= AIVOICE_QUALITY_NS_LOW) {
+		afe->ns_cost_mode = AFE_NS_COST_LOW;
+	}
+	if (level >= AIVOICE_QUALITY_SSL_OFF) {
+		afe->enable_ssl = false;
+	}
+}
+
+static int quality_differs(const struct afe_config *a, const struct afe_config *b)
+{
+	return (a->enable_aec && a->aec_cost != b->aec_cost) ||
+		   (a->enable_ns && a->ns_cost_mode != b->ns_cost_mode) ||
+		   a->enable_ssl != b->enable_ssl;
+}
+
+/* next level in direction step (1: down, -1: up) that changes the afe configuration, -1 if none */
+static int next_quality_level(struct aivoice_pipeline *pipeline, int step)
+{
+	const struct afe_config *base = pipeline->base_config->afe;
+	struct afe_config next;
+	struct afe_config prev;
+	int level = pipeline->quality_level + step;
+
+	for (; level >= 0 && level < AIVOICE_QUALITY_LEVEL_NUM; level += step) {
+		quality_afe_config(base, level, &next);
+		if (quality_differs(&pipeline->quality_afe, &next)) {
+			break;
+		}
+	}
+	if (level < 0 || level >= AIVOICE_QUALITY_LEVEL_NUM) {
+		return -1;
+	}
+
+	// going up, report the highest level with the same configuration
+	while (step < 0 && level > 0) {
+		quality_afe_config(base, level - 1, &prev);
+		if (quality_differs(&next, &prev)) {
+			break;
+		}
+		level--;
+	}
+	return level;
+}
+
+/* ask for the AFE of the next level in direction step, it is built by rtk_aivoice_pipeline_adapt_quality */
+static void request_quality(struct aivoice_pipeline *pipeline, int step)
+{
+	pipeline->over_frames = 0;
+	pipeline->under_frames = 0;
+	if (pipeline->quality_target >= 0 || pipeline->afe->update_pending) {
+		return;
+	}
+
+	int level = next_quality_level(pipeline, step);
+	if (level >= 0) {
+		pipeline->quality_target = level;
+		if (pipeline->pipeline_config.threaded) {
+			aivoice_port_sem_give(pipeline->frame_sem);
+		}
+	}
+}
+
+/* the AFE of level was switched in by apply_update */
+static void quality_changed(struct aivoice_pipeline *pipeline, int level)
+{
+	int from = pipeline->quality_level;
+
+	pipeline->quality_level = level;
+	pipeline->cost_seeded = 0;
+	pipeline->stats.quality_level = (unsigned int)level;
+	pipeline->stats.quality_changes++;
+
+	if (pipeline->quality_cb) {
+		struct aivoice_quality_event event = {
+			.from = (aivoice_quality_level_e)from,
+			.to = (aivoice_quality_level_e)level,
+			.cost_percent = pipeline->stats.cost_percent,
+			.afe = &pipeline->quality_afe,
+		};
+		pipeline->quality_cb(pipeline->quality_cb_user_data, &event);
+	}
+}
+
+/* average cost of feed against the frame period, with hysteresis between the two budgets */
+static void monitor_cost(struct aivoice_pipeline *pipeline, long long cost_us)
+{
+	const struct aivoice_pipeline_config *pc = &pipeline->pipeline_config;
+	long long period_us = AIVOICE_FRAME_MS * 1000;
+
+	if (!pipeline->cost_seeded) {
+		pipeline->cost_avg_us = cost_us;
+		pipeline->cost_seeded = 1;
+	} else {
+		pipeline->cost_avg_us += (cost_us - pipeline->cost_avg_us) / COST_AVG_FRAMES;
+	}
+	pipeline->stats.cost_percent = (unsigned int)(pipeline->cost_avg_us * 100 / period_us);
+	pipeline->stats.feed_us += cost_us;
+
+	if (!pc->quality_adapt) {
+		return;
+	}
+
+	if (pipeline->cost_avg_us * 100 > period_us * pc->budget_high_percent) {
+		pipeline->under_frames = 0;
+		if (++pipeline->over_frames * AIVOICE_FRAME_MS >= (unsigned int)pc->budget_down_ms) {
+			request_quality(pipeline, 1);
+		}
+	} else if (pipeline->cost_avg_us * 100 < period_us * pc->budget_low_percent) {
+		pipeline->over_frames = 0;
+		if (++pipeline->under_frames * AIVOICE_FRAME_MS >= (unsigned int)pc->budget_up_ms) {
+			request_quality(pipeline, -1);
+		}
+	} else {
+		pipeline->over_frames = 0;
+		pipeline->under_frames = 0;
+	}
+}
+
+struct aivoice_pipeline *aivoice_pipeline_create_plan(const struct aivoice_graph *graph,
+		const struct aivoice_pipeline_config *pipeline_config)
+{
+	struct aivoice_pipeline_config default_config = AIVOICE_PIPELINE_CONFIG_DEFAULT();
+	if (!pipeline_config) {
+		pipeline_config = &default_config;
+	}
+
+	if (pipeline_config->threaded && !is_power_of_2(pipeline_config->queue_frames)) {
+		PL_LOGE("queue_frames %d is not power of 2\n", pipeline_config->queue_frames);
+		return NULL;
+	}
+
+	struct aivoice_pipeline *pipeline = (struct aivoice_pipeline *)rtk_aivoice_mem_calloc(
+											sizeof(*pipeline), AIVOICE_MEMORY_CLASS_STATE);
+	if (!pipeline) {
+		return NULL;
+	}
+
+	pipeline->pipeline_config = *pipeline_config;
+	pipeline->num_nodes = graph->num_nodes;
+	memcpy(pipeline->order, graph->order, sizeof(pipeline->order));
+
+	for (int i = 0; i < graph->num_nodes; i++) {
+		const struct aivoice_plan_node *desc = &graph->nodes[i];
+		struct node *node = &pipeline->nodes[i];
+
+		node->pipeline = pipeline;
+		node->type = desc->type;
+		node->iface = node_ifaces[desc->type];
+		if (desc->config) {
+			node_config_set(&node->cfg, desc->config);
+			node->config = &node->cfg.config;
+		}
+		node->wake_gate = desc->wake_gate;
+		node->speech_gate = desc->speech_gate;
+		node->timeout_frames = session_frames(node->config);
+		node->lazy = pipeline_config->asr_lazy && desc->type == AIVOICE_NODE_ASR && desc->wake_gate >= 0;
+		node->loading = pipeline_config->staged_start && node->iface && desc->type != AIVOICE_NODE_AFE;
+		if (node->loading) {
+			pipeline->loading_nodes++;
+		}
+
+		unsigned int preroll_ms = 0;
+		if (desc->speech_gate >= 0) {
+			preroll_ms = (unsigned int)pipeline_config->gate_preroll_ms;
+		}
+		if (node->loading && (unsigned int)pipeline_config->load_preroll_ms > preroll_ms) {
+			preroll_ms = (unsigned int)pipeline_config->load_preroll_ms;
+		}
+		if (preroll_ms / AIVOICE_FRAME_MS > pipeline->history_frames) {
+			pipeline->history_frames = preroll_ms / AIVOICE_FRAME_MS;
+		}
+		if (desc->wake_gate >= 0) {
+			pipeline->nodes[desc->wake_gate].gates_nodes = 1;
+			if (desc->type == AIVOICE_NODE_ASR) {
+				pipeline->nodes[desc->wake_gate].gates_asr = 1;
+			}
+		}
+	}
+
+	if (graph->afe >= 0) {
+		// AFE runs on a copy of its config, changed by quality adaption
+		struct node *afe = &pipeline->nodes[graph->afe];
+		pipeline->base_config = &afe->cfg.config;
+		pipeline->quality_config = afe->cfg.config;
+		pipeline->quality_afe = afe->cfg.afe;
+		pipeline->quality_config.afe = &pipeline->quality_afe;
+		afe->config = &pipeline->quality_config;
+	}
+	pipeline->quality_target = -1;
+	pipeline->quality_next = -1;
+
+	for (int i = 0; i < pipeline->num_nodes; i++) {
+		struct node *node = &pipeline->nodes[pipeline->order[i]];
+		if (!node->lazy && !node->loading && create_node(node) != 0) {
+			goto fail;
+		}
+	}
+
+	pipeline->gate_ratio = 1.0f;
+	for (int db = 0; db < pipeline_config->gate_threshold_db; db++) {
+		pipeline->gate_ratio *= 1.2589254f;     /* 10^(1/10) */
+	}
+	pipeline->hangover_frames = (unsigned int)pipeline_config->gate_hangover_ms / AIVOICE_FRAME_MS;
+	if (pipeline->history_frames > 0) {
+		pipeline->history = (short *)rtk_aivoice_mem_alloc(
+								(size_t)pipeline->history_frames * AIVOICE_MONO_FRAME_BYTES,
+								AIVOICE_MEMORY_CLASS_SCRATCH);
+		if (!pipeline->history) {
+			goto fail;
+		}
+	}
+
+	pipeline->max_ch = 1;
+	if (graph->afe >= 0) {
+		pipeline->afe = &pipeline->nodes[graph->afe];
+		pipeline->max_ch = aivoice_afe_mic_num(pipeline->afe->config->afe);
+	}
+
+	if (pipeline_config->threaded) {
+		pipeline->capacity = (uint32_t)pipeline_config->queue_frames;
+		pipeline->mask = pipeline->capacity - 1;
+		pipeline->slots = (struct frame_slot *)rtk_aivoice_mem_calloc(
+							  pipeline->capacity * sizeof(struct frame_slot), AIVOICE_MEMORY_CLASS_STATE);
+		pipeline->audio = (short *)rtk_aivoice_mem_alloc(
+							  (size_t)pipeline->capacity * pipeline->max_ch * AIVOICE_MONO_FRAME_BYTES,
+							  AIVOICE_MEMORY_CLASS_SCRATCH);
+		pipeline->frame_sem = aivoice_port_sem_create(pipeline_config->queue_frames);
+		pipeline->space_sem = aivoice_port_sem_create(pipeline_config->queue_frames);
+		if (!pipeline->slots || !pipeline->audio || !pipeline->frame_sem || !pipeline->space_sem) {
+			goto fail;
+		}
+		for (uint32_t i = 0; i < pipeline->capacity; i++) {
+			pipeline->slots[i].audio = pipeline->audio + i * pipeline->max_ch * AIVOICE_FRAME_SAMPLES;
+		}
+	}
+
+	return pipeline;
+
+fail:
+	rtk_aivoice_pipeline_destroy(pipeline);
+	return NULL;
+}
+
+struct aivoice_pipeline *rtk_aivoice_pipeline_create(struct aivoice_config *config,
+		const struct aivoice_pipeline_config *pipeline_config)
+{
+	struct aivoice_pipeline_config default_config = AIVOICE_PIPELINE_CONFIG_DEFAULT();
+	struct aivoice_graph graph;
+	int afe, kws = -1, vad = -1;
+
+	if (!pipeline_config) {
+		pipeline_config = &default_config;
+	}
+	if (!config || !config->afe) {
+		PL_LOGE("afe config is required\n");
+		return NULL;
+	}
+
+	// the full flow: AFE feeds every stage, KWS gates VAD and ASR
+	aivoice_graph_init(&graph);
+	afe = rtk_aivoice_graph_add_node(&graph, AIVOICE_NODE_AFE, config);
+	if (pipeline_config->stages & AIVOICE_PIPELINE_STAGE_KWS) {
+		kws = rtk_aivoice_graph_add_node(&graph, AIVOICE_NODE_KWS, config);
+		rtk_aivoice_graph_connect(&graph, afe, kws, AIVOICE_EDGE_AUDIO);
+	}
+	if ((pipeline_config->stages & AIVOICE_PIPELINE_STAGE_VAD) ||
+		(kws >= 0 && pipeline_config->kws_gate == AIVOICE_PIPELINE_GATE_VAD)) {
+		vad = rtk_aivoice_graph_add_node(&graph, AIVOICE_NODE_VAD, config);
+		rtk_aivoice_graph_connect(&graph, afe, vad, AIVOICE_EDGE_AUDIO);
+	}
+	if (kws >= 0) {
+		// a gating VAD runs all the time, otherwise it only runs in the session
+		if (pipeline_config->kws_gate == AIVOICE_PIPELINE_GATE_VAD) {
+			rtk_aivoice_graph_connect(&graph, vad, kws, AIVOICE_EDGE_SPEECH_GATE);
+		} else if (vad >= 0) {
+			rtk_aivoice_graph_connect(&graph, kws, vad, AIVOICE_EDGE_WAKEUP_GATE);
+		}
+		if (pipeline_config->kws_gate == AIVOICE_PIPELINE_GATE_ENERGY) {
+			int energy = rtk_aivoice_graph_add_node(&graph, AIVOICE_NODE_ENERGY, NULL);
+			rtk_aivoice_graph_connect(&graph, afe, energy, AIVOICE_EDGE_AUDIO);
+			rtk_aivoice_graph_connect(&graph, energy, kws, AIVOICE_EDGE_SPEECH_GATE);
+		}
+	}
+	if (pipeline_config->stages & AIVOICE_PIPELINE_STAGE_ASR) {
+		int asr = rtk_aivoice_graph_add_node(&graph, AIVOICE_NODE_ASR, config);
+		rtk_aivoice_graph_connect(&graph, afe, asr, AIVOICE_EDGE_AUDIO);
+		if (kws >= 0) {
+			rtk_aivoice_graph_connect(&graph, kws, asr, AIVOICE_EDGE_WAKEUP_GATE);
+		}
+	}
+
+	if (aivoice_graph_plan(&graph) != 0) {
+		return NULL;
+	}
+	return aivoice_pipeline_create_plan(&graph, pipeline_config);
+}
+
+void rtk_aivoice_pipeline_destroy(struct aivoice_pipeline *pipeline)
+{
+	if (!pipeline) {
+		return;
+	}
+
+	for (int i = 0; i < pipeline->num_nodes; i++) {
+		struct node *node = &pipeline->nodes[i];
+		destroy_node(node);
+		if (node->next_handle) {
+			node->iface->destroy(node->next_handle);
+		}
+		rtk_aivoice_resource_close(node->next_res);
+		rtk_aivoice_resource_close(node->res);
+	}
+
+	aivoice_port_sem_delete(pipeline->frame_sem);
+	aivoice_port_sem_delete(pipeline->space_sem);
+	rtk_aivoice_mem_free(pipeline->slots);
+	rtk_aivoice_mem_free(pipeline->audio);
+	rtk_aivoice_mem_free(pipeline->history);
+	rtk_aivoice_mem_free(pipeline);
+}
+
+void rtk_aivoice_pipeline_reset(struct aivoice_pipeline *pipeline)
+{
+	if (pipeline->afe && pipeline->afe->handle) {
+		pipeline->afe->iface->reset(pipeline->afe->handle);
+	}
+
+	if (pipeline->pipeline_config.threaded) {
+		// the worker drops queued frames and resets recognition when it sees the new generation
+		wmb();
+		pipeline->gen++;
+	} else {
+		reset_recognition(pipeline);
+	}
+}
+
+int rtk_aivoice_pipeline_warmup(struct aivoice_pipeline *pipeline, const void *buf, int len)
+{
+	if (!pipeline->afe) {
+		PL_LOGE("warm-up requires an afe node\n");
+		return -1;
+	}
+	if (pipeline->afe->update_pending) {
+		apply_update(pipeline->afe);
+	}
+	if (!pipeline->afe->handle) {
+		return -1;
+	}
+	return rtk_aivoice_warmup_replay(pipeline->afe->iface, pipeline->afe->handle,
+									 aivoice_afe_frame_bytes(pipeline->afe->config->afe),
+									 buf, len, afe_callback, pipeline);
+}
+
+int rtk_aivoice_pipeline_feed(struct aivoice_pipeline *pipeline, char *input_data, int length)
+{
+	if (pipeline->afe) {
+		if (pipeline->afe->update_pending) {
+			apply_update(pipeline->afe);
+		}
+		if (!pipeline->afe->handle) {
+			return -1;
+		}
+		long long start_us = aivoice_port_time_us();
+		pipeline->wait_us = 0;
+		int ret = pipeline->afe->iface->feed(pipeline->afe->handle, input_data, length);
+		monitor_cost(pipeline, aivoice_port_time_us() - start_us - pipeline->wait_us);
+		return ret;
+	}
+
+	if (length != AIVOICE_MONO_FRAME_BYTES) {
+		PL_LOGE("feed %d bytes, expect %d bytes\n", length, AIVOICE_MONO_FRAME_BYTES);
+		return -1;
+	}
+	return submit_frame(pipeline, 1, (short *)input_data, NULL);
+}
+
+void rtk_aivoice_pipeline_register_callback(struct aivoice_pipeline *pipeline,
+		aivoice_callback_handler cb, void *user_data)
+{
+	pipeline->cb = cb;
+	pipeline->cb_user_data = user_data;
+}
+
+int rtk_aivoice_pipeline_register_node_callback(struct aivoice_pipeline *pipeline, int node,
+		aivoice_callback_handler cb, void *user_data)
+{
+	if (node < 0 || node >= pipeline->num_nodes) {
+		PL_LOGE("invalid node %d\n", node);
+		return -1;
+	}
+	pipeline->nodes[node].cb_user_data = user_data;
+	pipeline->nodes[node].cb = cb;
+	return 0;
+}
+
+/* module config of the node in config, NULL if config does not change it */
+static const void *module_config(const struct node *node, const struct aivoice_config *config)
+{
+	switch (node->type) {
+	case AIVOICE_NODE_AFE:
+		return config->afe;
+	case AIVOICE_NODE_VAD:
+		return config->vad;
+	case AIVOICE_NODE_KWS:
+		return config->kws;
+	case AIVOICE_NODE_ASR:
+		return config->asr;
+	default:
+		return NULL;
+	}
+}
+
+/* whether config changes the module config of the node */
+static int module_changed(const struct node *node, const struct aivoice_config *config)
+{
+	const void *module = module_config(node, config);
+	const void *current = module_config(node, &node->cfg.config);
+
+	if (!module) {
+		return 0;
+	}
+	if (!current) {
+		return 1;
+	}
+	switch (node->type) {
+	case AIVOICE_NODE_AFE:
+		return memcmp(module, current, sizeof(struct afe_config)) != 0;
+	case AIVOICE_NODE_VAD:
+		return memcmp(module, current, sizeof(struct vad_config)) != 0;
+	case AIVOICE_NODE_KWS:
+		return memcmp(module, current, sizeof(struct kws_config)) != 0;
+	case AIVOICE_NODE_ASR:
+		return memcmp(module, current, sizeof(struct asr_config)) != 0;
+	default:
+		return 0;
+	}
+}
+
+/* next_cfg of a node: its config, changed by its own module config in config, the timeout and resource */
+static void prepare_config(struct node *node, const struct aivoice_config *config, const char *resource)
+{
+	struct aivoice_config next = node->cfg.config;
+	struct aivoice_sdk_config common = AIVOICE_SDK_CONFIG_DEFAULT();
+
+	if (resource) {
+		next.resource = resource;
+	}
+	if (config && module_config(node, config)) {
+		switch (node->type) {
+		case AIVOICE_NODE_AFE:
+			next.afe = config->afe;
+			break;
+		case AIVOICE_NODE_VAD:
+			next.vad = config->vad;
+			break;
+		case AIVOICE_NODE_KWS:
+			next.kws = config->kws;
+			break;
+		case AIVOICE_NODE_ASR:
+			next.asr = config->asr;
+			break;
+		default:
+			break;
+		}
+	}
+	if (config && config->common) {
+		// only the session timeout can change
+		if (next.common) {
+			common = *next.common;
+		}
+		common.timeout = config->common->timeout;
+		next.common = &common;
+	}
+	node_config_set(&node->next_cfg, &next);
+}
+
+/*
+ * create the new instances of nodes with next_cfg prepared, all of them or none,
+ * then let the nodes switch between two frames. lazy nodes are recreated when used.
+ */
+static int commit_updates(struct aivoice_pipeline *pipeline, const int *targets, const int *create, int num)
+{
+	for (int n = 0; n < num; n++) {
+		struct node *node = &pipeline->nodes[targets[n]];
+
+		node->next_handle = NULL;
+		node->next_recreate = 0;
+		if (!create[n]) {
+			continue;
+		}
+		if (node->lazy) {
+			node->next_recreate = 1;
+			continue;
+		}
+		node->next_handle = node->iface->create(&node->next_cfg.config);
+		if (!node->next_handle) {
+			PL_LOGE("create node %d with new config failed\n", targets[n]);
+			for (int k = 0; k < n; k++) {
+				struct node *done = &pipeline->nodes[targets[k]];
+				if (done->next_handle) {
+					done->iface->destroy(done->next_handle);
+					done->next_handle = NULL;
+				}
+			}
+			return -1;
+		}
+		if (node->type == AIVOICE_NODE_AFE) {
+			rtk_aivoice_register_callback(node->next_handle, afe_callback, pipeline);
+		} else {
+			rtk_aivoice_register_callback(node->next_handle, node_callback, node);
+		}
+	}
+
+	wmb();
+	for (int n = 0; n < num; n++) {
+		pipeline->nodes[targets[n]].update_pending = 1;
+	}
+	return 0;
+}
+
+int rtk_aivoice_pipeline_update_config(struct aivoice_pipeline *pipeline, int node_id,
+									   const struct aivoice_config *config)
+{
+	int targets[AIVOICE_GRAPH_MAX_NODES];
+	int create[AIVOICE_GRAPH_MAX_NODES];
+	int num = 0;
+
+	if (!config || node_id < -1 || node_id >= pipeline->num_nodes) {
+		PL_LOGE("invalid update of node %d\n", node_id);
+		return -1;
+	}
+
+	for (int i = 0; i < pipeline->num_nodes; i++) {
+		struct node *node = &pipeline->nodes[i];
+		if ((node_id >= 0 && i != node_id) || !node->config) {
+			continue;
+		}
+		// an unchanged module keeps its instance, and AFE its converged state
+		if (!module_changed(node, config) && !(config->common && node->type == AIVOICE_NODE_KWS)) {
+			continue;
+		}
+		if (node->update_pending) {
+			PL_LOGE("update of node %d is not applied yet\n", i);
+			return -1;
+		}
+		if (node->loading) {
+			PL_LOGE("node %d is waiting for its models\n", i);
+			return -1;
+		}
+		targets[num++] = i;
+	}
+
+	// a quality step of AFE may be built in another thread
+	if (__sync_lock_test_and_set(&pipeline->update_lock, 1)) {
+		PL_LOGE("afe is being rebuilt, update later\n");
+		return -1;
+	}
+	int ret = -1;
+	for (int n = 0; n < num; n++) {
+		if (pipeline->nodes[targets[n]].update_pending) {
+			PL_LOGE("update of node %d is not applied yet\n", targets[n]);
+			goto out;
+		}
+	}
+
+	// create every new instance before any is switched, so the update is applied entirely or not at all
+	for (int n = 0; n < num; n++) {
+		struct node *node = &pipeline->nodes[targets[n]];
+		create[n] = module_changed(node, config);
+		prepare_config(node, config, NULL);
+	}
+
+	ret = commit_updates(pipeline, targets, create, num);
+out:
+	__sync_lock_release(&pipeline->update_lock);
+	return ret;
+}
+
+int rtk_aivoice_pipeline_adapt_quality(struct aivoice_pipeline *pipeline)
+{
+	struct node *afe = pipeline->afe;
+	int level = pipeline->quality_target;
+
+	if (!afe || level < 0 || afe->update_pending) {
+		return 0;
+	}
+	if (__sync_lock_test_and_set(&pipeline->update_lock, 1)) {
+		return 0;
+	}
+
+	// the old instance keeps running until the new one exists
+	rmb();
+	quality_afe_config(pipeline->base_config->afe, level, &pipeline->quality_next_afe);
+	pipeline->quality_next_config = *pipeline->base_config;
+	pipeline->quality_next_config.afe = &pipeline->quality_next_afe;
+	afe->next_handle = afe->iface->create(&pipeline->quality_next_config);
+	if (!afe->next_handle) {
+		PL_LOGE("afe of quality level %d failed, keep level %d\n", level, pipeline->quality_level);
+		pipeline->quality_target = -1;
+		__sync_lock_release(&pipeline->update_lock);
+		return -1;
+	}
+	rtk_aivoice_register_callback(afe->next_handle, afe_callback, pipeline);
+	afe->next_recreate = 0;
+	pipeline->quality_next = level;
+
+	wmb();
+	afe->update_pending = 1;
+	pipeline->quality_target = -1;
+	__sync_lock_release(&pipeline->update_lock);
+	return 1;
+}
+
+/* model type a node is created from, 0 if none */
+static int node_model_type(const struct node *node)
+{
+	switch (node->type) {
+	case AIVOICE_NODE_VAD:
+		return AIVOICE_MODEL_VAD;
+	case AIVOICE_NODE_KWS:
+		return AIVOICE_MODEL_KWS;
+	case AIVOICE_NODE_ASR:
+		return AIVOICE_MODEL_ASR;
+	default:
+		return 0;
+	}
+}
+
+int rtk_aivoice_pipeline_swap_model(struct aivoice_pipeline *pipeline, int node_id,
+									struct aivoice_resource *res, const struct aivoice_config *config)
+{
+	int targets[AIVOICE_GRAPH_MAX_NODES];
+	int create[AIVOICE_GRAPH_MAX_NODES];
+	int num = 0;
+	struct aivoice_model_entry entry;
+	const char *data = rtk_aivoice_resource_data(res);
+
+	if (!data || node_id < -1 || node_id >= pipeline->num_nodes) {
+		PL_LOGE("invalid model swap of node %d\n", node_id);
+		return -1;
+	}
+
+	for (int i = 0; i < pipeline->num_nodes; i++) {
+		struct node *node = &pipeline->nodes[i];
+		int type = node_model_type(node);
+		if ((node_id >= 0 && i != node_id) || type == 0 || !node->config) {
+			continue;
+		}
+		if (rtk_aivoice_resource_find(data, type, NULL, &entry) != 0) {
+			if (node_id >= 0) {
+				PL_LOGE("no model of node %d in resource\n", i);
+				return -1;
+			}
+			continue;
+		}
+		if (node->update_pending || node->loading) {
+			PL_LOGE("node %d is busy, swap its model later\n", i);
+			return -1;
+		}
+		targets[num++] = i;
+	}
+	if (num == 0) {
+		PL_LOGE("no node uses the models of the resource\n");
+		return -1;
+	}
+
+	for (int n = 0; n < num; n++) {
+		struct node *node = &pipeline->nodes[targets[n]];
+		prepare_config(node, config, data);
+		node->next_res = rtk_aivoice_resource_retain(res);
+		create[n] = 1;
+	}
+
+	if (commit_updates(pipeline, targets, create, num) != 0) {
+		for (int n = 0; n < num; n++) {
+			struct node *node = &pipeline->nodes[targets[n]];
+			rtk_aivoice_resource_close(node->next_res);
+			node->next_res = NULL;
+		}
+		return -1;
+	}
+	return 0;
+}
+
+int rtk_aivoice_pipeline_load_models(struct aivoice_pipeline *pipeline, const char *resource)
+{
+	int targets[AIVOICE_GRAPH_MAX_NODES];
+	int create[AIVOICE_GRAPH_MAX_NODES];
+	int num = 0;
+
+	if (!resource) {
+		return -1;
+	}
+
+	for (int i = 0; i < pipeline->num_nodes; i++) {
+		struct node *node = &pipeline->nodes[i];
+		if (!node->loading || node->update_pending) {
+			continue;
+		}
+		prepare_config(node, NULL, resource);
+		create[num] = 1;
+		targets[num++] = i;
+	}
+	if (num == 0) {
+		PL_LOGE("no node is waiting for models\n");
+		return -1;
+	}
+
+	return commit_updates(pipeline, targets, create, num);
+}
+
+void rtk_aivoice_pipeline_register_quality_callback(struct aivoice_pipeline *pipeline,
+		aivoice_quality_callback cb, void *user_data)
+{
+	pipeline->quality_cb = cb;
+	pipeline->quality_cb_user_data = user_data;
+}
+
+int rtk_aivoice_pipeline_process(struct aivoice_pipeline *pipeline, int timeout_ms)
+{
+	if (pipeline->stopped) {
+		return -1;
+	}
+	if (!pipeline->pipeline_config.threaded) {
+		return 0;
+	}
+
+	// the AFE of a quality step is built here, not in feed
+	if (pipeline->quality_target >= 0) {
+		rtk_aivoice_pipeline_adapt_quality(pipeline);
+	}
+
+	if (pipeline->head == pipeline->tail) {
+		aivoice_port_sem_take(pipeline->frame_sem, timeout_ms);
+		if (pipeline->stopped) {
+			return -1;
+		}
+	}
+
+	uint32_t head = pipeline->head;  // Get snapshot of head
+	uint32_t tail = pipeline->tail;
+	int count = 0;
+
+	rmb();
+	while (tail != head) {
+		struct frame_slot *slot = &pipeline->slots[tail & pipeline->mask];
+		uint32_t gen = pipeline->gen;
+
+		if (slot->gen == gen) {
+			if (gen != pipeline->worker_gen) {
+				reset_recognition(pipeline);
+				pipeline->worker_gen = gen;
+			}
+			process_frame(pipeline, slot->ch_num, slot->audio, slot->json);
+			count++;
+		}
+
+		tail++;
+		mb();
+		pipeline->tail = tail;
+		if (pipeline->feed_waiting) {
+			aivoice_port_sem_give(pipeline->space_sem);
+		}
+	}
+
+	return count;
+}
+
+void rtk_aivoice_pipeline_stop(struct aivoice_pipeline *pipeline)
+{
+	pipeline->stopped = 1;
+	if (pipeline->frame_sem) {
+		aivoice_port_sem_give(pipeline->frame_sem);
+	}
+}
+
+void rtk_aivoice_pipeline_get_stats(struct aivoice_pipeline *pipeline,
+									struct aivoice_pipeline_stats *stats)
+{
+	memcpy(stats, &pipeline->stats, sizeof(*stats));
+	if (stats->gated_frames > 0) {
+		stats->skipped_percent = (unsigned int)((unsigned long long)stats->skipped_frames * 100 /
+												stats->gated_frames);
+	}
+}
@@ -0,0 +1,42 @@
+#ifndef _AIVOICE_PLAN_H_
+#define _AIVOICE_PLAN_H_
+
+/*
+ * Graph description shared by the graph builder and the pipeline,
+ * not part of the public api.
+ */
+
+#include "aivoice_graph.h"
+
+struct aivoice_plan_node {
+	aivoice_node_type_e type;
+	struct aivoice_config *config;
+	int audio_src;              /* AFE node feeding this node, -1 if none */
+	int wake_gate;              /* KWS node gating this node, -1 if none */
+	int speech_gate;            /* VAD or ENERGY node gating this node, -1 if none */
+};
+
+/* config of a KWS node added by rtk_aivoice_graph_add_keywords */
+struct aivoice_plan_shard {
+	struct aivoice_config config;
+	struct kws_config kws;
+};
+
+struct aivoice_graph {
+	struct aivoice_plan_node nodes[AIVOICE_GRAPH_MAX_NODES];
+	int num_nodes;
+	int order[AIVOICE_GRAPH_MAX_NODES]; /* execution order, filled by aivoice_graph_plan */
+	int afe;                            /* AFE node, -1 if none */
+	struct aivoice_plan_shard *shards;  /* per node, allocated by rtk_aivoice_graph_add_keywords */
+};
+
+void aivoice_graph_init(struct aivoice_graph *graph);
+
+/* check the graph and fill execution order, 0 on success */
+int aivoice_graph_plan(struct aivoice_graph *graph);
+
+/* create a pipeline from a planned graph */
+struct aivoice_pipeline *aivoice_pipeline_create_plan(const struct aivoice_graph *graph,
+		const struct aivoice_pipeline_config *pipeline_config);
+
+#endif // _AIVOICE_PLAN_H_
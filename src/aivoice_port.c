@@ -0,0 +1,188 @@
+#include <stddef.h>
+
+#if defined(__linux__)
+#include <malloc.h>
+#include <time.h>
+#include <errno.h>
+#include <semaphore.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#else
+#include "FreeRTOS.h"
+#include "task.h"
+#include "semphr.h"
+#endif
+
+#include "aivoice_memory.h"
+#include "aivoice_port.h"
+#include "aivoice_allocator.h"
+
+#if defined(__XTENSA__)
+/* provided by libaivoice_hal, heap for AIVOICE_MEMORY_ALLOC_MODE_SRAM */
+extern size_t sram_get_free_size(void);
+#endif
+
+__attribute__((weak))
+long aivoice_port_heap_usage(int region)
+{
+	switch (region) {
+	case AIVOICE_MEMORY_REGION_DEFAULT:
+#if defined(__linux__)
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+		return (long)mallinfo2().uordblks;
+#else
+		return (long)mallinfo().uordblks;
+#endif
+#else
+		return -(long)xPortGetFreeHeapSize();
+#endif
+
+	case AIVOICE_MEMORY_REGION_SRAM:
+#if defined(__XTENSA__)
+		return -(long)sram_get_free_size();
+#else
+		return 0;
+#endif
+
+	default:
+		return 0;
+	}
+}
+
+__attribute__((weak))
+long long aivoice_port_time_us(void)
+{
+#if defined(__linux__)
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (long long)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+#else
+	return (long long)xTaskGetTickCount() * portTICK_PERIOD_MS * 1000;
+#endif
+}
+
+#if defined(__linux__)
+__attribute__((weak))
+void *aivoice_port_sem_create(int max_count)
+{
+	(void)max_count;
+
+	sem_t *sem = (sem_t *)rtk_aivoice_mem_alloc(sizeof(sem_t), AIVOICE_MEMORY_CLASS_STATE);
+	if (sem && sem_init(sem, 0, 0) != 0) {
+		rtk_aivoice_mem_free(sem);
+		return NULL;
+	}
+	return sem;
+}
+
+__attribute__((weak))
+void aivoice_port_sem_delete(void *sem)
+{
+	if (sem) {
+		sem_destroy((sem_t *)sem);
+		rtk_aivoice_mem_free(sem);
+	}
+}
+
+__attribute__((weak))
+void aivoice_port_sem_give(void *sem)
+{
+	sem_post((sem_t *)sem);
+}
+
+__attribute__((weak))
+int aivoice_port_sem_take(void *sem, int timeout_ms)
+{
+	int ret;
+
+	if (timeout_ms < 0) {
+		while ((ret = sem_wait((sem_t *)sem)) != 0 && errno == EINTR);
+		return ret == 0 ? 0 : -1;
+	}
+
+	struct timespec ts;
+	clock_gettime(CLOCK_REALTIME, &ts);
+	ts.tv_sec += timeout_ms / 1000;
+	ts.tv_nsec += (long)(timeout_ms % 1000) * 1000000;
+	if (ts.tv_nsec >= 1000000000) {
+		ts.tv_sec++;
+		ts.tv_nsec -= 1000000000;
+	}
+	while ((ret = sem_timedwait((sem_t *)sem, &ts)) != 0 && errno == EINTR);
+	return ret == 0 ? 0 : -1;
+}
+#else
+__attribute__((weak))
+void *aivoice_port_sem_create(int max_count)
+{
+	return (void *)xSemaphoreCreateCounting((UBaseType_t)max_count, 0);
+}
+
+__attribute__((weak))
+void aivoice_port_sem_delete(void *sem)
+{
+	if (sem) {
+		vSemaphoreDelete((SemaphoreHandle_t)sem);
+	}
+}
+
+__attribute__((weak))
+void aivoice_port_sem_give(void *sem)
+{
+	xSemaphoreGive((SemaphoreHandle_t)sem);
+}
+
+__attribute__((weak))
+int aivoice_port_sem_take(void *sem, int timeout_ms)
+{
+	TickType_t ticks = timeout_ms < 0 ? portMAX_DELAY : pdMS_TO_TICKS(timeout_ms);
+	return xSemaphoreTake((SemaphoreHandle_t)sem, ticks) == pdTRUE ? 0 : -1;
+}
+#endif
+
+#if defined(__linux__)
+__attribute__((weak))
+const void *aivoice_port_map_file(const char *path, unsigned int *size)
+{
+	int fd = open(path, O_RDONLY);
+	if (fd < 0) {
+		return NULL;
+	}
+
+	struct stat st;
+	void *addr = NULL;
+	if (fstat(fd, &st) == 0 && st.st_size > 0 && (unsigned long long)st.st_size <= 0xFFFFFFFFu) {
+		addr = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (addr == MAP_FAILED) {
+			addr = NULL;
+		} else {
+			*size = (unsigned int)st.st_size;
+		}
+	}
+	close(fd);
+	return addr;
+}
+
+__attribute__((weak))
+void aivoice_port_unmap_file(const void *addr, unsigned int size)
+{
+	munmap((void *)addr, size);
+}
+#else
+__attribute__((weak))
+const void *aivoice_port_map_file(const char *path, unsigned int *size)
+{
+	(void)path;
+	(void)size;
+	return NULL;
+}
+
+__attribute__((weak))
+void aivoice_port_unmap_file(const void *addr, unsigned int size)
+{
+	(void)addr;
+	(void)size;
+}
+#endif
@@ -0,0 +1,46 @@
+#ifndef _AIVOICE_PORT_H_
+#define _AIVOICE_PORT_H_
+
+/*
+ * Platform hooks used by aivoice utilities.
+ * Default implementations are weak, override them for other platforms.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Heap usage counter of one memory region (enum aivoice_memory_region_e).
+ *        Only the difference of two calls is meaningful.
+ *        Return 0 if the region can not be measured on this platform.
+ */
+long aivoice_port_heap_usage(int region);
+
+/**
+ * @brief Monotonic time in microseconds, used to stamp events.
+ */
+long long aivoice_port_time_us(void);
+
+/**
+ * @brief Counting semaphore, used between the feed thread and worker threads.
+ *        aivoice_port_sem_take returns 0 when taken, -1 on timeout.
+ *        timeout_ms < 0 waits forever.
+ */
+void *aivoice_port_sem_create(int max_count);
+void aivoice_port_sem_delete(void *sem);
+void aivoice_port_sem_give(void *sem);
+int aivoice_port_sem_take(void *sem, int timeout_ms);
+
+/**
+ * @brief Map a file read only, pages are loaded on first access.
+ *        Return NULL if files can not be mapped on this platform.
+ */
+const void *aivoice_port_map_file(const char *path, unsigned int *size);
+void aivoice_port_unmap_file(const void *addr, unsigned int size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // _AIVOICE_PORT_H_
@@ -0,0 +1,124 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "aivoice_reblock.h"
+#include "aivoice_allocator.h"
+#include "aivoice_port.h"
+#include "aivoice_utils.h"
+
+#define RB_LOGE(x, ...) printf("[AIVOICE] [REBLOCK] error: " x, ##__VA_ARGS__)
+
+struct aivoice_reblock {
+	const struct rtk_aivoice_iface *iface;
+	void *handle;
+
+	int frame_bytes;        /* bytes of one input frame */
+	int block_bytes;        /* bytes of one 256 samples block of all channels */
+
+	char *block;            /* incomplete block */
+	int pending;            /* bytes in block */
+
+	struct aivoice_reblock_stats stats;
+};
+
+static int feed_block(struct aivoice_reblock *reblock, char *data)
+{
+	long long start_us = aivoice_port_time_us();
+	int ret = reblock->iface->feed(reblock->handle, data, reblock->block_bytes);
+
+	reblock->stats.process_us += aivoice_port_time_us() - start_us;
+	reblock->stats.blocks++;
+	return ret;
+}
+
+struct aivoice_reblock *rtk_aivoice_reblock_create(const struct rtk_aivoice_iface *iface, void *handle,
+		int channels, int frame_samples)
+{
+	if (!iface || !handle || channels <= 0 || frame_samples <= 0) {
+		RB_LOGE("invalid parameters\n");
+		return NULL;
+	}
+
+	struct aivoice_reblock *reblock = (struct aivoice_reblock *)rtk_aivoice_mem_calloc(
+										  sizeof(*reblock), AIVOICE_MEMORY_CLASS_STATE);
+	if (!reblock) {
+		return NULL;
+	}
+
+	reblock->iface = iface;
+	reblock->handle = handle;
+	reblock->frame_bytes = channels * frame_samples * (int)sizeof(short);
+	reblock->block_bytes = channels * AIVOICE_FRAME_SAMPLES * (int)sizeof(short);
+	reblock->block = (char *)rtk_aivoice_mem_alloc(reblock->block_bytes, AIVOICE_MEMORY_CLASS_STATE);
+	if (!reblock->block) {
+		rtk_aivoice_mem_free(reblock);
+		return NULL;
+	}
+
+	return reblock;
+}
+
+void rtk_aivoice_reblock_destroy(struct aivoice_reblock *reblock)
+{
+	if (!reblock) {
+		return;
+	}
+	rtk_aivoice_mem_free(reblock->block);
+	rtk_aivoice_mem_free(reblock);
+}
+
+int rtk_aivoice_reblock_feed(struct aivoice_reblock *reblock, char *input_data, int length)
+{
+	if (length != reblock->frame_bytes) {
+		RB_LOGE("feed %d bytes, expect %d bytes\n", length, reblock->frame_bytes);
+		return -1;
+	}
+
+	int ret = 0;
+	reblock->stats.frames++;
+
+	// complete the pending block first
+	if (reblock->pending > 0) {
+		int n = reblock->block_bytes - reblock->pending;
+		if (n > length) {
+			n = length;
+		}
+		memcpy(reblock->block + reblock->pending, input_data, n);
+		reblock->pending += n;
+		input_data += n;
+		length -= n;
+		if (reblock->pending < reblock->block_bytes) {
+			return 0;
+		}
+		reblock->pending = 0;
+		ret = feed_block(reblock, reblock->block);
+	}
+
+	// whole blocks are fed from the input directly
+	while (length >= reblock->block_bytes) {
+		int r = feed_block(reblock, input_data);
+		if (ret == 0) {
+			ret = r;
+		}
+		input_data += reblock->block_bytes;
+		length -= reblock->block_bytes;
+	}
+
+	if (length > 0) {
+		memcpy(reblock->block, input_data, length);
+		reblock->pending = length;
+	}
+
+	return ret;
+}
+
+void rtk_aivoice_reblock_reset(struct aivoice_reblock *reblock)
+{
+	reblock->pending = 0;
+	reblock->iface->reset(reblock->handle);
+}
+
+void rtk_aivoice_reblock_get_stats(struct aivoice_reblock *reblock, struct aivoice_reblock_stats *stats)
+{
+	memcpy(stats, &reblock->stats, sizeof(*stats));
+}
@@ -0,0 +1,640 @@
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "aivoice_resource.h"
+#include "aivoice_allocator.h"
+#include "aivoice_port.h"
+#include "aivoice_lz4.h"
+#include "aivoice_crc32c.h"
+
+#define RES_LOGI(x, ...) printf("[AIVOICE] [RES] " x, ##__VA_ARGS__)
+#define RES_LOGE(x, ...) printf("[AIVOICE] [RES] error: " x, ##__VA_ARGS__)
+
+/* header of aivoice_models.bin, see tools/pack_resources/aivoice_bin_packer.py */
+#define RTAIBIN_MAGIC           "RTAIBIN"
+#define RTAIBIN_MAGIC_LEN       (8)
+#define RTAIBIN_OFFSET_VERSION  (8)
+#define RTAIBIN_OFFSET_SIZE     (12)
+#define RTAIBIN_OFFSET_COUNT    (16)
+#define RTAIBIN_HEADER_LEN      (20)
+#define RTAIBIN_ENTRY_LEN       (44)    /* type, size, offset, name[32] */
+#define RTAIBIN_ENTRY_TYPE      (0)
+#define RTAIBIN_ENTRY_SIZE      (4)
+#define RTAIBIN_ENTRY_OFFSET    (8)
+#define RTAIBIN_ENTRY_NAME      (12)
+#define RTAIBIN_ALIGNMENT       (1024)  /* header and entry table are padded to this */
+#define RTAIBIN_VERSION         (1)
+#define RTAIBIN_VERSION_ENCODED (2)     /* has lz4 or chunked models, only read by this loader */
+#define RTAIBIN_FLAG_LZ4        (0x80000000u)   /* in type: data is model size (u32) and an lz4 block */
+#define RTAIBIN_FLAG_CHUNKED    (0x40000000u)   /* in type: data is model size, chunk size, chunk count (u32),
+                                                   offset of each chunk (u32), then chunks */
+#define RTAIBIN_FLAGS           (RTAIBIN_FLAG_LZ4 | RTAIBIN_FLAG_CHUNKED)
+#define RTAIBIN_LZ4_PREFIX      (4)
+#define RTAIBIN_CHUNKED_PREFIX  (12)
+#define RTAIBIN_DIGEST_TAG      "CRCS"  /* after the entry table: tag and crc32c of the stored data of each model */
+#define RTAIBIN_DIGEST_TAG_LEN  (4)
+
+#define RES_VERIFY_CHUNK        (4096)  /* verify what was just copied, while it is in cache */
+
+typedef enum {
+	RESOURCE_COPIED = 0,        /* data is a heap copy */
+	RESOURCE_MAPPED = 1,        /* data is mapped by the caller */
+	RESOURCE_FILE = 2,          /* data is a file mapped by aivoice_port_map_file */
+} resource_storage_e;
+
+struct aivoice_resource {
+	const char *data;           /* AIVOICE_RESOURCE_ALIGNMENT aligned */
+	unsigned int size;
+	int model_num;
+	resource_storage_e storage;
+	unsigned int map_size;      /* RESOURCE_FILE: bytes mapped */
+	volatile int refcount;
+};
+
+static uint32_t read_le32(const void *p)
+{
+	const uint8_t *b = (const uint8_t *)p;
+	return (uint32_t)b[0] | ((uint32_t)b[1] << 8) | ((uint32_t)b[2] << 16) | ((uint32_t)b[3] << 24);
+}
+
+/*
+ * check header and entry table, only the first RTAIBIN_ALIGNMENT bytes are read,
+ * and the size prefix of encoded models.
+ * returns size, 0 if invalid. encoded is set when some models are lz4 compressed or chunked.
+ */
+static unsigned int check_header(const void *source, unsigned int size, int *encoded)
+{
+	const char *bin = (const char *)source;
+
+	if (memcmp(bin, RTAIBIN_MAGIC, RTAIBIN_MAGIC_LEN) != 0) {
+		RES_LOGE("invalid resource magic\n");
+		return 0;
+	}
+
+	uint32_t version = read_le32(bin + RTAIBIN_OFFSET_VERSION);
+	if (version != RTAIBIN_VERSION && version != RTAIBIN_VERSION_ENCODED) {
+		RES_LOGE("unsupported resource version %u\n", version);
+		return 0;
+	}
+
+	unsigned int bin_size = read_le32(bin + RTAIBIN_OFFSET_SIZE);
+	if (size == 0) {
+		size = bin_size;
+	}
+	if (size < RTAIBIN_HEADER_LEN || size > AIVOICE_RESOURCE_MAX_SIZE || size < bin_size) {
+		RES_LOGE("invalid resource size %u, header size %u, max %u\n",
+				 size, bin_size, (unsigned int)AIVOICE_RESOURCE_MAX_SIZE);
+		return 0;
+	}
+
+	uint32_t count = read_le32(bin + RTAIBIN_OFFSET_COUNT);
+	if (count > (RTAIBIN_ALIGNMENT - RTAIBIN_HEADER_LEN) / RTAIBIN_ENTRY_LEN) {
+		RES_LOGE("invalid model number %u\n", count);
+		return 0;
+	}
+	*encoded = 0;
+	for (uint32_t i = 0; i < count; i++) {
+		const char *entry = bin + RTAIBIN_HEADER_LEN + i * RTAIBIN_ENTRY_LEN;
+		uint32_t model_size = read_le32(entry + RTAIBIN_ENTRY_SIZE);
+		uint32_t model_offset = read_le32(entry + RTAIBIN_ENTRY_OFFSET);
+		if (model_offset < RTAIBIN_ALIGNMENT || model_offset > size || model_size > size - model_offset) {
+			RES_LOGE("model %u at %u size %u is out of the resource\n", i, model_offset, model_size);
+			return 0;
+		}
+		uint32_t flags = read_le32(entry + RTAIBIN_ENTRY_TYPE) & RTAIBIN_FLAGS;
+		if (flags) {
+			unsigned int prefix = flags == RTAIBIN_FLAG_LZ4 ? RTAIBIN_LZ4_PREFIX : RTAIBIN_CHUNKED_PREFIX;
+			if (version != RTAIBIN_VERSION_ENCODED || flags == RTAIBIN_FLAGS || model_size < prefix ||
+				read_le32(bin + model_offset) > AIVOICE_RESOURCE_MAX_SIZE) {
+				RES_LOGE("invalid encoded model %u\n", i);
+				return 0;
+			}
+			*encoded = 1;
+		}
+	}
+
+	return size;
+}
+
+static void write_le32(void *p, uint32_t v)
+{
+	uint8_t *b = (uint8_t *)p;
+	b[0] = (uint8_t)v;
+	b[1] = (uint8_t)(v >> 8);
+	b[2] = (uint8_t)(v >> 16);
+	b[3] = (uint8_t)(v >> 24);
+}
+
+/* digest table of the resource, NULL if it has none */
+static const char *digest_table(const char *bin)
+{
+	uint32_t count = read_le32(bin + RTAIBIN_OFFSET_COUNT);
+	unsigned int offset = RTAIBIN_HEADER_LEN + count * RTAIBIN_ENTRY_LEN;
+
+	if (offset + RTAIBIN_DIGEST_TAG_LEN + count * 4 > RTAIBIN_ALIGNMENT ||
+		memcmp(bin + offset, RTAIBIN_DIGEST_TAG, RTAIBIN_DIGEST_TAG_LEN) != 0) {
+		return NULL;
+	}
+	return bin + offset + RTAIBIN_DIGEST_TAG_LEN;
+}
+
+static void read_entry(const char *bin, int index, struct aivoice_model_entry *entry)
+{
+	const char *e = bin + RTAIBIN_HEADER_LEN + index * RTAIBIN_ENTRY_LEN;
+	const char *digests = digest_table(bin);
+
+	uint32_t type = read_le32(e + RTAIBIN_ENTRY_TYPE);
+
+	entry->type = (aivoice_model_type_e)(type & ~RTAIBIN_FLAGS);
+	entry->stored_size = read_le32(e + RTAIBIN_ENTRY_SIZE);
+	entry->offset = read_le32(e + RTAIBIN_ENTRY_OFFSET);
+	entry->compressed = (type & RTAIBIN_FLAG_LZ4) != 0;
+	entry->chunked = (type & RTAIBIN_FLAG_CHUNKED) != 0;
+	entry->size = type & RTAIBIN_FLAGS ? read_le32(bin + entry->offset) : entry->stored_size;
+	entry->has_crc = digests != NULL;
+	entry->crc = digests ? read_le32(digests + index * 4) : 0;
+	memcpy(entry->name, e + RTAIBIN_ENTRY_NAME, AIVOICE_MODEL_NAME_LEN);
+	entry->name[AIVOICE_MODEL_NAME_LEN - 1] = '\0';
+}
+
+/* copy in chunks, each chunk is added to the crc right after it is copied */
+static unsigned int copy_crc(char *dst, const char *src, unsigned int len)
+{
+	unsigned int crc = 0;
+
+	while (len > 0) {
+		unsigned int n = len < RES_VERIFY_CHUNK ? len : RES_VERIFY_CHUNK;
+		memcpy(dst, src, n);
+		crc = aivoice_crc32c(crc, dst, n);
+		dst += n;
+		src += n;
+		len -= n;
+	}
+	return crc;
+}
+
+/*
+ * crc of a chunked model, rebuilt into dst when dst is not NULL.
+ * returns 0 on success, -1 when the chunk table is invalid.
+ */
+static int rebuild_chunks(char *dst, const char *bin, const struct aivoice_model_entry *entry, unsigned int *crc)
+{
+	const char *table = bin + entry->offset;
+	unsigned int bin_size = read_le32(bin + RTAIBIN_OFFSET_SIZE);
+	uint32_t chunk_size = read_le32(table + 4);
+	uint32_t count = read_le32(table + 8);
+
+	if (chunk_size == 0 || count != (entry->size + chunk_size - 1) / chunk_size ||
+		count > (entry->stored_size - RTAIBIN_CHUNKED_PREFIX) / 4) {
+		RES_LOGE("invalid chunk table of model %s\n", entry->name);
+		return -1;
+	}
+
+	*crc = 0;
+	for (uint32_t i = 0; i < count; i++) {
+		uint32_t offset = read_le32(table + RTAIBIN_CHUNKED_PREFIX + i * 4);
+		unsigned int len = i + 1 < count ? chunk_size : entry->size - i * chunk_size;
+		if (offset > bin_size || len > bin_size - offset) {
+			RES_LOGE("chunk %u of model %s is out of the resource\n", i, entry->name);
+			return -1;
+		}
+		if (dst) {
+			memcpy(dst + i * chunk_size, bin + offset, len);
+			*crc = aivoice_crc32c(*crc, dst + i * chunk_size, len);
+		} else {
+			*crc = aivoice_crc32c(*crc, bin + offset, len);
+		}
+	}
+	return 0;
+}
+
+/* load the stored data of one model to dst, decoded and verified. returns 0 on success */
+static int load_model(char *dst, const char *bin, const struct aivoice_model_entry *entry)
+{
+	const char *src = bin + entry->offset;
+
+	if (entry->chunked) {
+		unsigned int crc;
+		if (rebuild_chunks(dst, bin, entry, &crc) != 0) {
+			return -1;
+		}
+		if (entry->has_crc && crc != entry->crc) {
+			RES_LOGE("model %s crc mismatch\n", entry->name);
+			return -1;
+		}
+		return 0;
+	}
+
+	if (!entry->compressed) {
+		if (!entry->has_crc) {
+			memcpy(dst, src, entry->size);
+		} else if (copy_crc(dst, src, entry->size) != entry->crc) {
+			RES_LOGE("model %s crc mismatch\n", entry->name);
+			return -1;
+		}
+		return 0;
+	}
+
+	// the compressed data is smaller, check it before decoding
+	if (entry->has_crc && aivoice_crc32c(0, src, entry->stored_size) != entry->crc) {
+		RES_LOGE("model %s crc mismatch\n", entry->name);
+		return -1;
+	}
+	if (aivoice_lz4_decode(src + RTAIBIN_LZ4_PREFIX, entry->stored_size - RTAIBIN_LZ4_PREFIX,
+						   dst, entry->size) != 0) {
+		RES_LOGE("decode model %s failed\n", entry->name);
+		return -1;
+	}
+	return 0;
+}
+
+static unsigned int align_up(unsigned int n, unsigned int alignment)
+{
+	return (n + alignment - 1) / alignment * alignment;
+}
+
+static struct aivoice_resource *new_resource(const char *data, unsigned int size, resource_storage_e storage)
+{
+	struct aivoice_resource *res = (struct aivoice_resource *)rtk_aivoice_mem_calloc(sizeof(*res),
+								   AIVOICE_MEMORY_CLASS_STATE);
+	if (!res) {
+		return NULL;
+	}
+
+	res->data = data;
+	res->size = size;
+	res->model_num = (int)read_le32(data + RTAIBIN_OFFSET_COUNT);
+	res->storage = storage;
+	res->refcount = 1;
+	return res;
+}
+
+/* model replacing the first model of its type, or added when the resource has none */
+struct replacement {
+	int type;
+	const char *data;
+	unsigned int size;
+	const char *name;
+};
+
+static struct aivoice_resource *open_selected(const void *source, unsigned int model_mask,
+		const char *const *names, int num_names, const struct replacement *rep);
+
+struct aivoice_resource *rtk_aivoice_resource_open(const void *source, unsigned int size)
+{
+	int encoded;
+
+	if (!source) {
+		return NULL;
+	}
+
+	size = check_header(source, size, &encoded);
+	if (size == 0) {
+		return NULL;
+	}
+	if (encoded || digest_table((const char *)source)) {
+		return open_selected(source, ~0u, NULL, 0, NULL);
+	}
+
+	long long start_us = aivoice_port_time_us();
+
+	char *data = (char *)rtk_aivoice_mem_aligned_alloc(size, AIVOICE_RESOURCE_ALIGNMENT,
+				 AIVOICE_MEMORY_CLASS_WEIGHTS);
+	if (!data) {
+		RES_LOGE("malloc %u bytes failed\n", size);
+		return NULL;
+	}
+
+	memcpy(data, source, size);
+	struct aivoice_resource *res = new_resource(data, size, RESOURCE_COPIED);
+	if (!res) {
+		rtk_aivoice_mem_free(data);
+		return NULL;
+	}
+	RES_LOGI("load resource %u bytes, %d models in %lld us\n", size, res->model_num,
+			 aivoice_port_time_us() - start_us);
+
+	return res;
+}
+
+int rtk_aivoice_resource_list(const void *source, struct aivoice_model_entry *entries, int max_entries)
+{
+	int encoded;
+
+	if (!source || check_header(source, 0, &encoded) == 0) {
+		return -1;
+	}
+
+	int count = (int)read_le32((const char *)source + RTAIBIN_OFFSET_COUNT);
+	for (int i = 0; entries && i < count && i < max_entries; i++) {
+		read_entry((const char *)source, i, &entries[i]);
+	}
+	return count;
+}
+
+int rtk_aivoice_resource_find(const void *source, int type, const char *name, struct aivoice_model_entry *entry)
+{
+	int count = rtk_aivoice_resource_list(source, NULL, 0);
+
+	for (int i = 0; i < count; i++) {
+		read_entry((const char *)source, i, entry);
+		if ((type == 0 || (int)entry->type == type) &&
+			(!name || strncmp(entry->name, name, AIVOICE_MODEL_NAME_LEN - 1) == 0)) {
+			return 0;
+		}
+	}
+	return -1;
+}
+
+/* models of model_mask, and of names when names is not NULL */
+static int is_selected(const struct aivoice_model_entry *entry, unsigned int model_mask,
+					   const char *const *names, int num_names)
+{
+	if ((unsigned int)entry->type >= 32 || !(model_mask & AIVOICE_MODEL_MASK(entry->type))) {
+		return 0;
+	}
+	if (!names) {
+		return 1;
+	}
+	for (int i = 0; i < num_names; i++) {
+		if (names[i] && strncmp(entry->name, names[i], AIVOICE_MODEL_NAME_LEN - 1) == 0) {
+			return 1;
+		}
+	}
+	return 0;
+}
+
+static void write_entry(char *e, int type, unsigned int size, unsigned int offset, const char *name)
+{
+	write_le32(e + RTAIBIN_ENTRY_TYPE, (uint32_t)type);
+	write_le32(e + RTAIBIN_ENTRY_SIZE, size);
+	write_le32(e + RTAIBIN_ENTRY_OFFSET, offset);
+	if (name) {
+		memset(e + RTAIBIN_ENTRY_NAME, 0, AIVOICE_MODEL_NAME_LEN);
+		strncpy(e + RTAIBIN_ENTRY_NAME, name, AIVOICE_MODEL_NAME_LEN - 1);
+	}
+}
+
+static struct aivoice_resource *open_selected(const void *source, unsigned int model_mask,
+		const char *const *names, int num_names, const struct replacement *rep)
+{
+	const char *bin = (const char *)source;
+	int count = rtk_aivoice_resource_list(source, NULL, 0);
+	if (count < 0) {
+		return NULL;
+	}
+
+	long long start_us = aivoice_port_time_us();
+
+	// a version 1 resource with the selected models, each model aligned
+	struct aivoice_model_entry entry;
+	unsigned int size = RTAIBIN_ALIGNMENT;
+	int selected = 0;
+	int replace = -1;
+	for (int i = 0; i < count; i++) {
+		read_entry(bin, i, &entry);
+		if (rep && replace < 0 && (int)entry.type == rep->type) {
+			replace = i;
+			size += align_up(rep->size, AIVOICE_RESOURCE_ALIGNMENT);
+			selected++;
+		} else if (is_selected(&entry, model_mask, names, num_names)) {
+			size += align_up(entry.size, AIVOICE_RESOURCE_ALIGNMENT);
+			selected++;
+		}
+	}
+	if (rep && replace < 0) {
+		replace = count;
+		size += align_up(rep->size, AIVOICE_RESOURCE_ALIGNMENT);
+		selected++;
+	}
+	size = align_up(size, RTAIBIN_ALIGNMENT);
+	if (selected == 0) {
+		RES_LOGE("no model of mask 0x%x%s in resource\n", model_mask, names ? " and names" : "");
+		return NULL;
+	}
+	if (RTAIBIN_HEADER_LEN + selected * RTAIBIN_ENTRY_LEN > RTAIBIN_ALIGNMENT) {
+		RES_LOGE("%d models do not fit in the header\n", selected);
+		return NULL;
+	}
+	if (size > AIVOICE_RESOURCE_MAX_SIZE) {
+		RES_LOGE("decoded resource size %u exceeds max %u\n", size, (unsigned int)AIVOICE_RESOURCE_MAX_SIZE);
+		return NULL;
+	}
+
+	char *data = (char *)rtk_aivoice_mem_aligned_alloc(size, AIVOICE_RESOURCE_ALIGNMENT,
+				 AIVOICE_MEMORY_CLASS_WEIGHTS);
+	if (!data) {
+		RES_LOGE("malloc %u bytes failed\n", size);
+		return NULL;
+	}
+
+	memset(data, 0, RTAIBIN_ALIGNMENT);
+	memcpy(data, bin, RTAIBIN_HEADER_LEN);
+	write_le32(data + RTAIBIN_OFFSET_VERSION, RTAIBIN_VERSION);
+	write_le32(data + RTAIBIN_OFFSET_SIZE, size);
+	write_le32(data + RTAIBIN_OFFSET_COUNT, (uint32_t)selected);
+
+	unsigned int offset = RTAIBIN_ALIGNMENT;
+	int n = 0;
+	for (int i = 0; i <= count; i++) {
+		char *e = data + RTAIBIN_HEADER_LEN + n * RTAIBIN_ENTRY_LEN;
+		unsigned int padded;
+
+		if (i == replace) {
+			write_entry(e, rep->type, rep->size, offset, rep->name);
+			memcpy(data + offset, rep->data, rep->size);
+			padded = align_up(rep->size, AIVOICE_RESOURCE_ALIGNMENT);
+			memset(data + offset + rep->size, 0, padded - rep->size);
+			offset += padded;
+			n++;
+			continue;
+		}
+		if (i == count) {
+			break;
+		}
+		read_entry(bin, i, &entry);
+		if (!is_selected(&entry, model_mask, names, num_names)) {
+			continue;
+		}
+		memcpy(e, bin + RTAIBIN_HEADER_LEN + i * RTAIBIN_ENTRY_LEN, RTAIBIN_ENTRY_LEN);
+		write_entry(e, entry.type, entry.size, offset, NULL);
+
+		// encoded models are decoded straight into their place
+		padded = align_up(entry.size, AIVOICE_RESOURCE_ALIGNMENT);
+		if (load_model(data + offset, bin, &entry) != 0) {
+			rtk_aivoice_mem_free(data);
+			return NULL;
+		}
+		memset(data + offset + entry.size, 0, padded - entry.size);
+		offset += padded;
+		n++;
+	}
+	memset(data + offset, 0, size - offset);
+
+	struct aivoice_resource *res = new_resource(data, size, RESOURCE_COPIED);
+	if (!res) {
+		rtk_aivoice_mem_free(data);
+		return NULL;
+	}
+	RES_LOGI("load %d of %d models, %u bytes in %lld us\n", selected, replace == count ? count + 1 : count,
+			 size, aivoice_port_time_us() - start_us);
+
+	return res;
+}
+
+int rtk_aivoice_resource_verify(const void *source)
+{
+	struct aivoice_model_entry entry;
+	int count = rtk_aivoice_resource_list(source, NULL, 0);
+	int verified = 0;
+
+	for (int i = 0; i < count; i++) {
+		read_entry((const char *)source, i, &entry);
+		if (!entry.has_crc) {
+			continue;
+		}
+		unsigned int crc = 0;
+		if (entry.chunked) {
+			if (rebuild_chunks(NULL, (const char *)source, &entry, &crc) != 0) {
+				return -1;
+			}
+		} else {
+			crc = aivoice_crc32c(0, (const char *)source + entry.offset, entry.stored_size);
+		}
+		if (crc != entry.crc) {
+			RES_LOGE("model %s crc mismatch\n", entry.name);
+			return -1;
+		}
+		verified++;
+	}
+	return count < 0 ? -1 : verified;
+}
+
+struct aivoice_resource *rtk_aivoice_resource_open_models(const void *source, unsigned int model_mask)
+{
+	return open_selected(source, model_mask, NULL, 0, NULL);
+}
+
+struct aivoice_resource *rtk_aivoice_resource_open_names(const void *source, const char *const *names, int num_names)
+{
+	if (!names || num_names <= 0) {
+		return NULL;
+	}
+	return open_selected(source, ~0u, names, num_names, NULL);
+}
+
+struct aivoice_resource *rtk_aivoice_resource_open_replace(const void *source, int type,
+		const void *model, unsigned int size, const char *name)
+{
+	if (!model || size == 0 || type <= 0 || type >= 32) {
+		return NULL;
+	}
+	struct replacement rep = {
+		.type = type,
+		.data = (const char *)model,
+		.size = size,
+		.name = name ? name : "",
+	};
+	return open_selected(source, ~0u, NULL, 0, &rep);
+}
+
+struct aivoice_resource *rtk_aivoice_resource_map(const void *addr, unsigned int size)
+{
+	if (!addr) {
+		return NULL;
+	}
+	if ((uintptr_t)addr % AIVOICE_RESOURCE_ALIGNMENT != 0) {
+		RES_LOGE("resource at %p is not %d bytes aligned\n", addr, AIVOICE_RESOURCE_ALIGNMENT);
+		return NULL;
+	}
+
+	int encoded;
+	size = check_header(addr, size, &encoded);
+	if (size == 0) {
+		return NULL;
+	}
+	if (encoded) {
+		RES_LOGE("compressed or chunked resource can not be used in place, open it instead\n");
+		return NULL;
+	}
+
+	struct aivoice_resource *res = new_resource((const char *)addr, size, RESOURCE_MAPPED);
+	if (res) {
+		RES_LOGI("map resource %u bytes at %p, %d models\n", size, addr, res->model_num);
+	}
+	return res;
+}
+
+struct aivoice_resource *rtk_aivoice_resource_map_file(const char *path)
+{
+	unsigned int file_size = 0;
+	const void *addr = aivoice_port_map_file(path, &file_size);
+	if (!addr) {
+		RES_LOGE("map %s failed\n", path);
+		return NULL;
+	}
+
+	// the file may be padded, only the size in the header is used
+	struct aivoice_resource *res = NULL;
+	int encoded = 0;
+	unsigned int size = file_size >= RTAIBIN_ALIGNMENT ? check_header(addr, 0, &encoded) : 0;
+	if (encoded) {
+		RES_LOGE("compressed or chunked resource can not be used in place, open it instead\n");
+	} else if (size > 0 && size <= file_size) {
+		res = new_resource((const char *)addr, size, RESOURCE_FILE);
+	} else if (size > file_size) {
+		RES_LOGE("%s is truncated, %u bytes of %u\n", path, file_size, size);
+	}
+	if (!res) {
+		aivoice_port_unmap_file(addr, file_size);
+		return NULL;
+	}
+
+	res->map_size = file_size;
+	RES_LOGI("map %s %u bytes, %d models\n", path, size, res->model_num);
+	return res;
+}
+
+struct aivoice_resource *rtk_aivoice_resource_retain(struct aivoice_resource *res)
+{
+	if (res) {
+		__sync_fetch_and_add(&res->refcount, 1);
+	}
+	return res;
+}
+
+void rtk_aivoice_resource_close(struct aivoice_resource *res)
+{
+	if (!res) {
+		return;
+	}
+
+	if (__sync_sub_and_fetch(&res->refcount, 1) == 0) {
+		switch (res->storage) {
+		case RESOURCE_COPIED:
+			rtk_aivoice_mem_free((void *)res->data);
+			break;
+		case RESOURCE_FILE:
+			aivoice_port_unmap_file(res->data, res->map_size);
+			break;
+		default:
+			break;
+		}
+		rtk_aivoice_mem_free(res);
+	}
+}
+
+const char *rtk_aivoice_resource_data(const struct aivoice_resource *res)
+{
+	return res ? res->data : NULL;
+}
+
+void rtk_aivoice_resource_get_info(const struct aivoice_resource *res, struct aivoice_resource_info *info)
+{
+	info->data = res->data;
+	info->size = res->size;
+	info->model_num = res->model_num;
+	info->mapped = res->storage != RESOURCE_COPIED;
+	info->refcount = res->refcount;
+}
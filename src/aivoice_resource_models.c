@@ -0,0 +1,43 @@
+#include "aivoice_resource.h"
+
+/*
+ * Apart from aivoice_resource.c on purpose: it references every flow, and
+ * would link all of them into any image using the resource loader.
+ */
+
+unsigned int rtk_aivoice_resource_models_of(const struct rtk_aivoice_iface *iface,
+		const struct aivoice_config *config)
+{
+	unsigned int mask;
+	int nnns = !config || (config->afe && config->afe->enable_ns && config->afe->ns_mode == AFE_NS_NN);
+	int agr = !config || (config->kws && config->kws->enable_age_gender);
+
+	if (iface == &aivoice_iface_full_flow_v1) {
+		mask = AIVOICE_MODEL_MASK(AIVOICE_MODEL_AFE) | AIVOICE_MODEL_MASK(AIVOICE_MODEL_VAD) |
+			   AIVOICE_MODEL_MASK(AIVOICE_MODEL_KWS) | AIVOICE_MODEL_MASK(AIVOICE_MODEL_ASR) |
+			   AIVOICE_MODEL_MASK(AIVOICE_MODEL_FST);
+	} else if (iface == &aivoice_iface_afe_kws_vad_v1) {
+		mask = AIVOICE_MODEL_MASK(AIVOICE_MODEL_AFE) | AIVOICE_MODEL_MASK(AIVOICE_MODEL_VAD) |
+			   AIVOICE_MODEL_MASK(AIVOICE_MODEL_KWS);
+	} else if (iface == &aivoice_iface_afe_kws_v1) {
+		mask = AIVOICE_MODEL_MASK(AIVOICE_MODEL_AFE) | AIVOICE_MODEL_MASK(AIVOICE_MODEL_KWS);
+	} else if (iface == &aivoice_iface_afe_v1) {
+		mask = AIVOICE_MODEL_MASK(AIVOICE_MODEL_AFE);
+	} else if (iface == &aivoice_iface_vad_v1) {
+		mask = AIVOICE_MODEL_MASK(AIVOICE_MODEL_VAD);
+	} else if (iface == &aivoice_iface_kws_v1) {
+		mask = AIVOICE_MODEL_MASK(AIVOICE_MODEL_KWS);
+	} else if (iface == &aivoice_iface_asr_v1) {
+		mask = AIVOICE_MODEL_MASK(AIVOICE_MODEL_ASR) | AIVOICE_MODEL_MASK(AIVOICE_MODEL_FST);
+	} else {
+		return 0;
+	}
+
+	if (nnns && (mask & AIVOICE_MODEL_MASK(AIVOICE_MODEL_AFE))) {
+		mask |= AIVOICE_MODEL_MASK(AIVOICE_MODEL_NNNS);
+	}
+	if (agr && (mask & AIVOICE_MODEL_MASK(AIVOICE_MODEL_KWS))) {
+		mask |= AIVOICE_MODEL_MASK(AIVOICE_MODEL_AGR);
+	}
+	return mask;
+}
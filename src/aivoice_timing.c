@@ -0,0 +1,129 @@
+#include <string.h>
+
+#include "aivoice_timing.h"
+#include "aivoice_allocator.h"
+#include "aivoice_port.h"
+
+struct latency_window {
+	long long samples[AIVOICE_LATENCY_WINDOW];
+	unsigned int count;
+};
+
+struct aivoice_timing {
+	const struct rtk_aivoice_iface *iface;
+	void *handle;
+
+	aivoice_stamped_callback_handler cb;
+	void *cb_user_data;
+
+	struct aivoice_event_stamp stamp;   /* stamp of the frame being fed */
+	int stream_started;
+
+	struct latency_window latency[AIVOICE_LATENCY_EVENT_NUM];
+};
+
+static int timing_callback(void *user_data, enum aivoice_out_event_type event_type,
+						   const void *msg, int len)
+{
+	struct aivoice_timing *timing = (struct aivoice_timing *)user_data;
+	struct aivoice_event_stamp stamp = timing->stamp;
+
+	stamp.complete_us = aivoice_port_time_us();
+
+	if ((int)event_type >= 0 && event_type < AIVOICE_LATENCY_EVENT_NUM && stamp.capture_us) {
+		struct latency_window *w = &timing->latency[event_type];
+		w->samples[w->count % AIVOICE_LATENCY_WINDOW] = stamp.complete_us - stamp.capture_us;
+		w->count++;
+	}
+
+	if (timing->cb) {
+		return timing->cb(timing->cb_user_data, event_type, msg, len, &stamp);
+	}
+	return 0;
+}
+
+struct aivoice_timing *rtk_aivoice_timing_create(const struct rtk_aivoice_iface *iface, void *handle)
+{
+	if (!iface || !handle) {
+		return NULL;
+	}
+
+	struct aivoice_timing *timing = (struct aivoice_timing *)rtk_aivoice_mem_calloc(
+										sizeof(*timing), AIVOICE_MEMORY_CLASS_STATE);
+	if (!timing) {
+		return NULL;
+	}
+
+	timing->iface = iface;
+	timing->handle = handle;
+	rtk_aivoice_register_callback(handle, timing_callback, timing);
+
+	return timing;
+}
+
+void rtk_aivoice_timing_destroy(struct aivoice_timing *timing)
+{
+	rtk_aivoice_mem_free(timing);
+}
+
+void rtk_aivoice_timing_register_callback(struct aivoice_timing *timing,
+		aivoice_stamped_callback_handler cb, void *user_data)
+{
+	timing->cb = cb;
+	timing->cb_user_data = user_data;
+}
+
+int rtk_aivoice_feed_ts(struct aivoice_timing *timing, char *input_data, int length, long long capture_time_us)
+{
+	if (!timing->stream_started) {
+		timing->stamp.stream_start_us = capture_time_us;
+		timing->stream_started = 1;
+	}
+	timing->stamp.capture_us = capture_time_us;
+
+	return timing->iface->feed(timing->handle, input_data, length);
+}
+
+void rtk_aivoice_timing_reset(struct aivoice_timing *timing)
+{
+	timing->iface->reset(timing->handle);
+	timing->stream_started = 0;
+}
+
+void rtk_aivoice_timing_get_latency(struct aivoice_timing *timing,
+									enum aivoice_out_event_type event_type,
+									struct aivoice_latency_stats *stats)
+{
+	long long sorted[AIVOICE_LATENCY_WINDOW];
+
+	memset(stats, 0, sizeof(*stats));
+	if ((int)event_type < 0 || event_type >= AIVOICE_LATENCY_EVENT_NUM) {
+		return;
+	}
+
+	const struct latency_window *w = &timing->latency[event_type];
+	unsigned int n = w->count < AIVOICE_LATENCY_WINDOW ? w->count : AIVOICE_LATENCY_WINDOW;
+
+	stats->count = w->count;
+	stats->window = n;
+	if (n == 0) {
+		return;
+	}
+
+	// insertion sort, the window is small
+	for (unsigned int i = 0; i < n; i++) {
+		long long v = w->samples[i];
+		unsigned int j = i;
+		while (j > 0 && sorted[j - 1] > v) {
+			sorted[j] = sorted[j - 1];
+			j--;
+		}
+		sorted[j] = v;
+	}
+
+	stats->min_us = sorted[0];
+	stats->p50_us = sorted[(n - 1) * 50 / 100];
+	stats->p90_us = sorted[(n - 1) * 90 / 100];
+	stats->p99_us = sorted[(n - 1) * 99 / 100];
+	stats->max_us = sorted[n - 1];
+}
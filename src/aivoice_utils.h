@@ -0,0 +1,33 @@
+#ifndef _AIVOICE_UTILS_H_
+#define _AIVOICE_UTILS_H_
+
+/*
+ * Helpers shared by aivoice utilities, not part of the public api.
+ */
+
+#include "aivoice_interface.h"
+
+#define AIVOICE_SAMPLE_RATE         (16000)
+#define AIVOICE_FRAME_SAMPLES       (256)   /* afe_config.frame_size, and one frame of single module flows */
+#define AIVOICE_FRAME_MS            (AIVOICE_FRAME_SAMPLES * 1000 / AIVOICE_SAMPLE_RATE)
+#define AIVOICE_MONO_FRAME_BYTES    (AIVOICE_FRAME_SAMPLES * (int)sizeof(short))
+
+static inline int aivoice_afe_mic_num(const struct afe_config *afe)
+{
+	switch (afe->mic_array) {
+	case AFE_1MIC:
+		return 1;
+	case AFE_CIRCLE_3MIC_50MM:
+		return 3;
+	default:
+		return 2;
+	}
+}
+
+/* bytes of one frame fed to flows with AFE: mic channels and ref channels interleaved */
+static inline int aivoice_afe_frame_bytes(const struct afe_config *afe)
+{
+	return (aivoice_afe_mic_num(afe) + afe->ref_num) * afe->frame_size * (int)sizeof(short);
+}
+
+#endif // _AIVOICE_UTILS_H_
@@ -0,0 +1,179 @@
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "aivoice_warmup.h"
+#include "aivoice_allocator.h"
+#include "aivoice_utils.h"
+
+#define WU_LOGE(x, ...) printf("[AIVOICE] [WARMUP] error: " x, ##__VA_ARGS__)
+
+/* blob header, little endian */
+#define WARMUP_MAGIC                "AIVWRMUP"
+#define WARMUP_MAGIC_LEN            (8)
+#define WARMUP_OFFSET_VERSION       (8)
+#define WARMUP_OFFSET_FRAME_BYTES   (12)
+#define WARMUP_OFFSET_FRAMES        (16)
+#define WARMUP_OFFSET_RESERVED      (20)
+
+struct aivoice_warmup_recorder {
+	char *frames;
+	uint32_t frame_bytes;
+	uint32_t capacity;          /* frames */
+	uint32_t count;             /* frames recorded, up to capacity */
+	uint32_t next;              /* slot of the next frame */
+};
+
+static uint32_t read_le32(const void *p)
+{
+	const uint8_t *b = (const uint8_t *)p;
+	return (uint32_t)b[0] | ((uint32_t)b[1] << 8) | ((uint32_t)b[2] << 16) | ((uint32_t)b[3] << 24);
+}
+
+static void write_le32(void *p, uint32_t v)
+{
+	uint8_t *b = (uint8_t *)p;
+	b[0] = (uint8_t)v;
+	b[1] = (uint8_t)(v >> 8);
+	b[2] = (uint8_t)(v >> 16);
+	b[3] = (uint8_t)(v >> 24);
+}
+
+struct aivoice_warmup_recorder *rtk_aivoice_warmup_recorder_create(int frame_bytes, int history_ms)
+{
+	if (frame_bytes <= 0 || history_ms < AIVOICE_FRAME_MS) {
+		WU_LOGE("invalid frame_bytes %d or history_ms %d\n", frame_bytes, history_ms);
+		return NULL;
+	}
+
+	struct aivoice_warmup_recorder *rec = (struct aivoice_warmup_recorder *)rtk_aivoice_mem_calloc(
+			sizeof(*rec), AIVOICE_MEMORY_CLASS_STATE);
+	if (!rec) {
+		return NULL;
+	}
+
+	rec->frame_bytes = (uint32_t)frame_bytes;
+	rec->capacity = (uint32_t)(history_ms / AIVOICE_FRAME_MS);
+	rec->frames = (char *)rtk_aivoice_mem_alloc((size_t)rec->capacity * rec->frame_bytes,
+				  AIVOICE_MEMORY_CLASS_STATE);
+	if (!rec->frames) {
+		rtk_aivoice_mem_free(rec);
+		return NULL;
+	}
+
+	return rec;
+}
+
+void rtk_aivoice_warmup_recorder_destroy(struct aivoice_warmup_recorder *rec)
+{
+	if (!rec) {
+		return;
+	}
+
+	rtk_aivoice_mem_free(rec->frames);
+	rtk_aivoice_mem_free(rec);
+}
+
+int rtk_aivoice_warmup_recorder_push(struct aivoice_warmup_recorder *rec, const char *input_data, int length)
+{
+	if (length != (int)rec->frame_bytes) {
+		return -1;
+	}
+
+	memcpy(rec->frames + (size_t)rec->next * rec->frame_bytes, input_data, rec->frame_bytes);
+	rec->next = (rec->next + 1) % rec->capacity;
+	if (rec->count < rec->capacity) {
+		rec->count++;
+	}
+	return 0;
+}
+
+int rtk_aivoice_warmup_save(struct aivoice_warmup_recorder *rec, void *buf, int *len)
+{
+	int size = AIVOICE_WARMUP_HEADER_LEN + (int)(rec->count * rec->frame_bytes);
+
+	if (!buf) {
+		*len = size;
+		return 0;
+	}
+	if (*len < size) {
+		*len = size;
+		return -1;
+	}
+
+	char *out = (char *)buf;
+	memcpy(out, WARMUP_MAGIC, WARMUP_MAGIC_LEN);
+	write_le32(out + WARMUP_OFFSET_VERSION, AIVOICE_WARMUP_VERSION);
+	write_le32(out + WARMUP_OFFSET_FRAME_BYTES, rec->frame_bytes);
+	write_le32(out + WARMUP_OFFSET_FRAMES, rec->count);
+	write_le32(out + WARMUP_OFFSET_RESERVED, 0);
+	out += AIVOICE_WARMUP_HEADER_LEN;
+
+	// oldest frame first
+	uint32_t first = (rec->next + rec->capacity - rec->count) % rec->capacity;
+	for (uint32_t i = 0; i < rec->count; i++) {
+		uint32_t slot = (first + i) % rec->capacity;
+		memcpy(out, rec->frames + (size_t)slot * rec->frame_bytes, rec->frame_bytes);
+		out += rec->frame_bytes;
+	}
+
+	*len = size;
+	return 0;
+}
+
+static int silent_callback(void *user_data, enum aivoice_out_event_type event_type,
+						   const void *msg, int len)
+{
+	(void)user_data;
+	(void)event_type;
+	(void)msg;
+	(void)len;
+	return 0;
+}
+
+int rtk_aivoice_warmup_replay(const struct rtk_aivoice_iface *iface, void *handle, int frame_bytes,
+							  const void *buf, int len,
+							  aivoice_callback_handler cb, void *user_data)
+{
+	const char *in = (const char *)buf;
+
+	// replay into a flow with recognition would detect what was said before power down
+	if (iface != &aivoice_iface_afe_v1) {
+		WU_LOGE("warm-up replay only supports aivoice_iface_afe_v1\n");
+		return -1;
+	}
+	if (!handle || !buf || len < AIVOICE_WARMUP_HEADER_LEN ||
+		memcmp(in, WARMUP_MAGIC, WARMUP_MAGIC_LEN) != 0) {
+		WU_LOGE("invalid warm-up blob\n");
+		return -1;
+	}
+
+	uint32_t version = read_le32(in + WARMUP_OFFSET_VERSION);
+	uint32_t blob_frame_bytes = read_le32(in + WARMUP_OFFSET_FRAME_BYTES);
+	uint32_t frames = read_le32(in + WARMUP_OFFSET_FRAMES);
+
+	if (version != AIVOICE_WARMUP_VERSION) {
+		WU_LOGE("unsupported warm-up version %u\n", (unsigned int)version);
+		return -1;
+	}
+	if (frame_bytes <= 0 || blob_frame_bytes != (uint32_t)frame_bytes) {
+		WU_LOGE("warm-up of %u bytes frames, instance takes %d bytes\n", (unsigned int)blob_frame_bytes, frame_bytes);
+		return -1;
+	}
+	if ((uint64_t)frames * blob_frame_bytes != (uint64_t)len - AIVOICE_WARMUP_HEADER_LEN) {
+		WU_LOGE("warm-up size mismatch, %u frames x %u bytes, blob %d bytes\n",
+				(unsigned int)frames, (unsigned int)blob_frame_bytes, len);
+		return -1;
+	}
+
+	rtk_aivoice_register_callback(handle, silent_callback, NULL);
+
+	in += AIVOICE_WARMUP_HEADER_LEN;
+	for (uint32_t i = 0; i < frames; i++) {
+		iface->feed(handle, (char *)in, frame_bytes);
+		in += frame_bytes;
+	}
+
+	rtk_aivoice_register_callback(handle, cb, user_data);
+	return 0;
+}
@@ -0,0 +1,92 @@
+/*
+ * Host stand-in for the prebuilt aivoice library, so the sources in src/ can
+ * be unit tested without the SDK. Every iface creates an instance that
+ * outputs the first mic of each frame as AIVOICE_EVOUT_AFE when the flow
+ * contains AFE, and nothing else. aivoice_stub_feed_bytes keeps the sizes fed.
+ */
+#include <stdlib.h>
+
+#include "aivoice_interface.h"
+
+/* bytes of the last frame fed to an AFE flow and to a flow without AFE */
+int aivoice_stub_feed_bytes[2];
+
+struct stub_instance {
+	aivoice_callback_handler callback;
+	void *userdata;
+	int afe;
+	short out[256];
+};
+
+static void *stub_create(int afe)
+{
+	struct stub_instance *inst = (struct stub_instance *)calloc(1, sizeof(*inst));
+	if (inst) {
+		inst->afe = afe;
+	}
+	return inst;
+}
+
+static void stub_destroy(void *handle)
+{
+	free(handle);
+}
+
+static void stub_reset(void *handle)
+{
+	(void)handle;
+}
+
+static int stub_feed(void *handle, char *data, int len)
+{
+	struct stub_instance *inst = (struct stub_instance *)handle;
+
+	aivoice_stub_feed_bytes[inst->afe] = len;
+	if (inst->afe && inst->callback) {
+		struct aivoice_evout_afe afe_out = { 1, inst->out, "{\"abnormal_flag\":0,\"ssl_angle\":-10}" };
+		for (int i = 0; i < 256; i++) {
+			inst->out[i] = ((short *)data)[i];
+		}
+		inst->callback(inst->userdata, AIVOICE_EVOUT_AFE, &afe_out, sizeof(afe_out));
+	}
+	return 0;
+}
+
+void rtk_aivoice_register_callback(void *handle, aivoice_callback_handler callback, void *userdata)
+{
+	struct stub_instance *inst = (struct stub_instance *)handle;
+	inst->callback = callback;
+	inst->userdata = userdata;
+}
+
+void rtk_aivoice_trigger_ssl(void *handle, int duration)
+{
+	(void)handle;
+	(void)duration;
+}
+
+afe_ns_mode_e AFE_NS_SIGNAL_SET(void)
+{
+	return AFE_NS_SIGNAL;
+}
+
+afe_ns_mode_e AFE_NS_NN_SET(void)
+{
+	return AFE_NS_NN;
+}
+
+#define STUB_IFACE(name, afe) \
+	static void *name##_create(struct aivoice_config *config) \
+	{ \
+		(void)config; \
+		return stub_create(afe); \
+	} \
+	const struct rtk_aivoice_iface name = { name##_create, stub_destroy, stub_reset, stub_feed };
+
+STUB_IFACE(aivoice_iface_full_flow_v1, 1)
+STUB_IFACE(aivoice_iface_afe_kws_v1, 1)
+STUB_IFACE(aivoice_iface_afe_kws_vad_v1, 1)
+STUB_IFACE(aivoice_iface_afe_v1, 1)
+STUB_IFACE(aivoice_iface_vad_v1, 0)
+STUB_IFACE(aivoice_iface_kws_v1, 0)
+STUB_IFACE(aivoice_iface_asr_v1, 0)
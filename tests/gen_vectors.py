@@ -0,0 +1,82 @@
+'''
+write the test vectors made by the packer tool into a directory:
+    python gen_vectors.py <out_dir>
+
+lz4_<case>.raw and lz4_<case>.lz4: a block compressed by lz4_compress_block.
+crc_<case>.raw: data, crc32c.txt: one line "<case> <crc32c in hex>" per case.
+vad_variants.bin, vad_variants_dedup.bin: the VAD bins of prebuilts/bin packed with --variants,
+and with --dedup.
+'''
+
+import os
+import sys
+import random
+import contextlib
+
+ROOT_DIR = os.path.join(os.path.dirname(os.path.abspath(__file__)), '..')
+PREBUILT_BINS = os.path.join(ROOT_DIR, 'prebuilts', 'bin')
+
+sys.path.insert(0, os.path.join(ROOT_DIR, 'tools', 'pack_resources'))
+import aivoice_bin_packer as packer
+
+def lz4_cases():
+    rng = random.Random(1)
+    text = b'aivoice lz4 test vector, repeated text compresses well. ' * 40
+    return {
+        'empty': b'',
+        'short': b'hello aivoi',                               # under LZ4_MF_LIMIT, literals only
+        'run': b'\x00' * 70000 + b'tail of the run',          # match length over 64 KB
+        'runs': (b'\x11' * 66000 + b'\x22' * 300) * 2,        # repeats further than LZ4_MAX_OFFSET
+        'random': bytes(rng.getrandbits(8) for _ in range(5000)),   # incompressible
+        'text': text,
+    }
+
+def crc_cases():
+    rng = random.Random(2)
+    return {
+        'empty': b'',
+        'byte': b'a',
+        'check': b'123456789',                                  # the standard check value, e3069283
+        'odd': bytes(range(256)) * 3 + b'xyz',                  # not a multiple of 4 or 8
+        'random': bytes(rng.getrandbits(8) for _ in range(4099)),
+    }
+
+def pack(out_path, matched_bins, **kwargs):
+    with open(os.devnull, 'w') as devnull, contextlib.redirect_stdout(devnull):
+        return packer.pack_models(matched_bins, PREBUILT_BINS, out_path, variants=True, **kwargs)
+
+def pack_variants(out_dir):
+    vad_bins = sorted(f for f in os.listdir(PREBUILT_BINS) if f.startswith('vad_'))
+    if not pack(os.path.join(out_dir, 'vad_variants.bin'), {'VAD': vad_bins}):
+        sys.exit('packing VAD variants failed')
+    if not pack(os.path.join(out_dir, 'vad_variants_dedup.bin'), {'VAD': vad_bins}, dedup=True):
+        sys.exit('packing VAD variants with dedup failed')
+
+    # names are cut to 31 chars, these two can not be told apart and must be refused
+    kws_bins = ['kws_xiaoqiangxiaoqiang_nihaoxiaoqiang_v4_300K.bin',
+                'kws_xiaoqiangxiaoqiang_nihaoxiaoqiang_v5_125K.bin']
+    if pack(os.path.join(out_dir, 'kws_collision.bin'), {'KWS': kws_bins}):
+        sys.exit('KWS variants colliding at 31 chars were packed')
+
+def write(out_dir, name, data):
+    with open(os.path.join(out_dir, name), 'wb') as f:
+        f.write(data)
+
+def main():
+    out_dir = sys.argv[1]
+    os.makedirs(out_dir, exist_ok=True)
+
+    for name, raw in lz4_cases().items():
+        write(out_dir, 'lz4_%s.raw' % name, raw)
+        write(out_dir, 'lz4_%s.lz4' % name, packer.lz4_compress_block(raw))
+
+    lines = []
+    for name, data in crc_cases().items():
+        write(out_dir, 'crc_%s.raw' % name, data)
+        lines.append('%s %08x\n' % (name, packer.crc32c(data)))
+    write(out_dir, 'crc32c.txt', ''.join(lines).encode())
+
+    pack_variants(out_dir)
+
+if __name__ == '__main__':
+    main()
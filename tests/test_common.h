@@ -0,0 +1,44 @@
+#ifndef _AIVOICE_TEST_COMMON_H_
+#define _AIVOICE_TEST_COMMON_H_
+
+#include <stdio.h>
+#include <stdlib.h>
+
+static int test_failures;
+
+#define CHECK(cond) \
+	do { \
+		if (!(cond)) { \
+			printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+			test_failures++; \
+		} \
+	} while (0)
+
+#define TEST_RESULT() (test_failures ? (printf("%d check(s) failed\n", test_failures), 1) : 0)
+
+/* read a whole file, NULL when it can not be read */
+static inline unsigned char *read_file(const char *dir, const char *name, unsigned int *size)
+{
+	char path[512];
+	snprintf(path, sizeof(path), "%s/%s", dir, name);
+
+	FILE *f = fopen(path, "rb");
+	if (!f) {
+		printf("can not open %s\n", path);
+		return NULL;
+	}
+	fseek(f, 0, SEEK_END);
+	long len = ftell(f);
+	fseek(f, 0, SEEK_SET);
+
+	unsigned char *data = (unsigned char *)malloc(len > 0 ? (size_t)len : 1);
+	if (data && fread(data, 1, (size_t)len, f) != (size_t)len) {
+		free(data);
+		data = NULL;
+	}
+	fclose(f);
+	*size = (unsigned int)len;
+	return data;
+}
+
+#endif // _AIVOICE_TEST_COMMON_H_
@@ -0,0 +1,88 @@
+#include <pthread.h>
+#include <string.h>
+
+#include "aivoice_crc32c.h"
+#include "test_common.h"
+
+#define FIRST_CALL_THREADS  4
+
+static const unsigned char check_data[] = "123456789";
+static unsigned int first_call_crc[FIRST_CALL_THREADS];
+
+static void *first_call_thread(void *arg)
+{
+	unsigned int *crc = (unsigned int *)arg;
+	*crc = aivoice_crc32c(0, check_data, 9);
+	return NULL;
+}
+
+// run first, so the threads race to build the table
+static void test_concurrent_first_call(void)
+{
+	pthread_t threads[FIRST_CALL_THREADS];
+
+	for (int i = 0; i < FIRST_CALL_THREADS; i++) {
+		pthread_create(&threads[i], NULL, first_call_thread, &first_call_crc[i]);
+	}
+	for (int i = 0; i < FIRST_CALL_THREADS; i++) {
+		pthread_join(threads[i], NULL);
+		CHECK(first_call_crc[i] == 0xe3069283u);
+	}
+}
+
+static void test_vectors(const char *dir)
+{
+	unsigned int size;
+	unsigned char *list = read_file(dir, "crc32c.txt", &size);
+	CHECK(list != NULL);
+	if (!list) {
+		return;
+	}
+
+	char *text = (char *)realloc(list, size + 1);
+	text[size] = '\0';
+
+	int cases = 0;
+	char name[32];
+	unsigned int expected;
+	int consumed;
+	for (const char *p = text; sscanf(p, "%31s %x%n", name, &expected, &consumed) == 2; p += consumed) {
+		char file[64];
+		unsigned int len;
+		snprintf(file, sizeof(file), "crc_%s.raw", name);
+		unsigned char *data = read_file(dir, file, &len);
+		CHECK(data != NULL);
+		if (!data) {
+			continue;
+		}
+
+		unsigned int crc = aivoice_crc32c(0, data, len);
+		if (crc != expected) {
+			printf("%s: crc32c %08x, packer %08x\n", name, crc, expected);
+			CHECK(0);
+		}
+
+		// any split gives the same crc
+		for (unsigned int split = 0; split <= len && split < 16; split++) {
+			unsigned int part = aivoice_crc32c(0, data, split);
+			CHECK(aivoice_crc32c(part, data + split, len - split) == expected);
+		}
+
+		cases++;
+		free(data);
+	}
+	CHECK(cases > 0);
+	free(text);
+}
+
+int main(int argc, char *argv[])
+{
+	if (argc < 2) {
+		printf("usage: %s <vectors dir>\n", argv[0]);
+		return 1;
+	}
+
+	test_concurrent_first_call();
+	test_vectors(argv[1]);
+	return TEST_RESULT();
+}
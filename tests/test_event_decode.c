@@ -0,0 +1,133 @@
+#include <math.h>
+#include <string.h>
+
+#include "aivoice_event_decode.h"
+#include "test_common.h"
+
+#define NEAR(a, b) (fabs((double)(a) - (double)(b)) < 1e-5)
+
+static void test_wakeup(void)
+{
+	struct aivoice_evout_wakeup w;
+
+	CHECK(rtk_aivoice_decode_wakeup("{\"id\":2,\"keyword\":\"xiao qiang\",\"score\":0.875}", -1, &w) == 0);
+	CHECK(w.id == 2 && NEAR(w.score, 0.875));
+
+	// nested objects and arrays are skipped, their members are not the top level ones
+	CHECK(rtk_aivoice_decode_wakeup("{ \"meta\" : {\"id\":9, \"list\":[{\"id\":8},[1,2]]},\n"
+									"  \"id\" : 3 , \"score\" : 1 }", -1, &w) == 0);
+	CHECK(w.id == 3 && NEAR(w.score, 1));
+
+	// escaped quotes inside strings, also in keys
+	CHECK(rtk_aivoice_decode_wakeup("{\"keyword\":\"say \\\"id\\\":7\",\"a\\\"id\":6,\"id\":4}", -1, &w) == 0);
+	CHECK(w.id == 4);
+	CHECK(rtk_aivoice_decode_wakeup("{\"keyword\":\"back\\\\\",\"id\":5}", -1, &w) == 0);
+	CHECK(w.id == 5);
+
+	// negative and exponent numbers
+	CHECK(rtk_aivoice_decode_wakeup("{\"id\":-1,\"score\":-2.5e-1}", -1, &w) == 0);
+	CHECK(w.id == -1 && NEAR(w.score, -0.25));
+	CHECK(rtk_aivoice_decode_wakeup("{\"id\":1E+2,\"score\":5e-1}", -1, &w) == 0);
+	CHECK(w.id == 100 && NEAR(w.score, 0.5));
+	CHECK(rtk_aivoice_decode_wakeup("{\"id\":1,\"score\":1e999999999}", -1, &w) == 0);
+
+	// missing keys: id is required, score is optional
+	CHECK(rtk_aivoice_decode_wakeup("{\"keyword\":\"x\",\"score\":0.9}", -1, &w) != 0);
+	CHECK(rtk_aivoice_decode_wakeup("{\"id\":7}", -1, &w) == 0);
+	CHECK(w.id == 7 && w.score == 0);
+	CHECK(rtk_aivoice_decode_wakeup("{\"id\":\"7\"}", -1, &w) != 0);
+	CHECK(rtk_aivoice_decode_wakeup("{}", -1, &w) != 0);
+	CHECK(rtk_aivoice_decode_wakeup("", -1, &w) != 0);
+	CHECK(rtk_aivoice_decode_wakeup("[{\"id\":1}]", -1, &w) != 0);
+	CHECK(rtk_aivoice_decode_wakeup("{\"keyword\":\"unterminated,\"id\":1", -1, &w) != 0);
+	CHECK(rtk_aivoice_decode_wakeup(NULL, -1, &w) != 0);
+}
+
+static void test_len(void)
+{
+	struct aivoice_evout_wakeup w;
+	struct aivoice_evout_asr asr;
+	const char *json = "{\"id\":3,\"score\":0.5}{\"id\":9}";
+
+	// len -1 reads to '\0', the first member found wins
+	CHECK(rtk_aivoice_decode_wakeup(json, -1, &w) == 0);
+	CHECK(w.id == 3);
+
+	// len stops before the following bytes
+	CHECK(rtk_aivoice_decode_wakeup(json, 20, &w) == 0);
+	CHECK(w.id == 3 && NEAR(w.score, 0.5));
+	CHECK(rtk_aivoice_decode_wakeup(json, 5, &w) != 0);
+	CHECK(rtk_aivoice_decode_wakeup(json, 0, &w) != 0);
+
+	// not '\0' terminated, nothing past len is read
+	char buf[] = { '{', '"', 'i', 'd', '"', ':', '4', '2', '}' };
+	CHECK(rtk_aivoice_decode_wakeup(buf, sizeof(buf), &w) == 0);
+	CHECK(w.id == 42);
+	char cut[] = { '{', '"', 'c', 'o', 'm', 'm', 'a', 'n', 'd', 's', '"', ':' };
+	CHECK(rtk_aivoice_decode_asr(cut, sizeof(cut), &asr) != 0);
+	CHECK(rtk_aivoice_decode_wakeup(cut, sizeof(cut), &w) != 0);
+}
+
+static void test_asr(void)
+{
+	struct aivoice_evout_asr asr;
+
+	CHECK(rtk_aivoice_decode_asr("{\"type\":0,\"commands\":[{\"rec\":\"da kai kong tiao\",\"id\":1}]}", -1, &asr) == 0);
+	CHECK(asr.type == 0 && asr.num_commands == 1 && asr.command_ids[0] == 1);
+
+	CHECK(rtk_aivoice_decode_asr("{\"commands\" : [ {\"rec\":\"a \\\"b\\\"\",\"extra\":{\"id\":99},\"id\":3} ,"
+								 " {\"id\":4}, {\"rec\":\"no id\"}, {\"id\":5}, {\"id\":6}, {\"id\":7} ],"
+								 " \"type\":2, \"conf\":-1.5e1}", -1, &asr) == 0);
+	CHECK(asr.type == 2 && NEAR(asr.conf, -15));
+	CHECK(asr.num_commands == AIVOICE_ASR_MAX_COMMANDS);
+	CHECK(asr.command_ids[0] == 3 && asr.command_ids[1] == 4 &&
+		  asr.command_ids[2] == 5 && asr.command_ids[3] == 6);
+
+	CHECK(rtk_aivoice_decode_asr("{\"type\":1,\"commands\":[]}", -1, &asr) == 0);
+	CHECK(asr.type == 1 && asr.num_commands == 0);
+	CHECK(rtk_aivoice_decode_asr("{\"type\":1}", -1, &asr) != 0);
+	CHECK(rtk_aivoice_decode_asr("{\"commands\":{\"id\":1}}", -1, &asr) != 0);
+}
+
+static void test_age_gender(void)
+{
+	struct aivoice_evout_age_gender ag;
+
+	CHECK(rtk_aivoice_decode_age_gender("{\"result\":2}", -1, &ag) == 0);
+	CHECK(ag.result == AIVOICE_AGE_GENDER_ADULT_MALE);
+	CHECK(rtk_aivoice_decode_age_gender("{\"type\":\"adult_female\"}", -1, &ag) == 0);
+	CHECK(ag.result == AIVOICE_AGE_GENDER_ADULT_FEMALE);
+	CHECK(rtk_aivoice_decode_age_gender("{\"result\":-1}", -1, &ag) == 0);
+	CHECK(ag.result == AIVOICE_AGE_GENDER_UNKNOWN);
+	CHECK(rtk_aivoice_decode_age_gender("{\"result\":\"adult\"}", -1, &ag) != 0);
+	CHECK(rtk_aivoice_decode_age_gender("{\"score\":1}", -1, &ag) != 0);
+	CHECK(ag.result == AIVOICE_AGE_GENDER_UNKNOWN);
+}
+
+static void test_afe_info(void)
+{
+	struct aivoice_evout_afe_info info;
+
+	CHECK(rtk_aivoice_decode_afe_info("{\"abnormal_flag\":1,\"ssl_angle\":90.5}", -1, &info) == 0);
+	CHECK(info.flags == (AIVOICE_AFE_FLAG_ABNORMAL | AIVOICE_AFE_FLAG_SSL_ANGLE) && NEAR(info.ssl_angle, 90.5));
+
+	// a negative angle is not valid
+	CHECK(rtk_aivoice_decode_afe_info("{\"abnormal_flag\":0,\"ssl_angle\":-10}", -1, &info) == 0);
+	CHECK(info.flags == 0);
+	CHECK(rtk_aivoice_decode_afe_info("{\"ssl_angle\":1.8e2}", -1, &info) == 0);
+	CHECK(info.flags == AIVOICE_AFE_FLAG_SSL_ANGLE && NEAR(info.ssl_angle, 180));
+
+	CHECK(rtk_aivoice_decode_afe_info(NULL, -1, &info) == 0 && info.flags == 0);
+	CHECK(rtk_aivoice_decode_afe_info("", -1, &info) == 0 && info.flags == 0);
+	CHECK(rtk_aivoice_decode_afe_info("{}", -1, &info) == 0 && info.flags == 0);
+}
+
+int main(void)
+{
+	test_wakeup();
+	test_len();
+	test_asr();
+	test_age_gender();
+	test_afe_info();
+	return TEST_RESULT();
+}
@@ -0,0 +1,92 @@
+#include <string.h>
+
+#include "aivoice_event_queue.h"
+#include "test_common.h"
+
+#define FRAME_SAMPLES   256
+#define CHANNEL_BYTES   (FRAME_SAMPLES * (int)sizeof(short))
+
+static short frame[3 * FRAME_SAMPLES];
+
+static void push_afe(struct aivoice_event_queue *queue, int ch_num)
+{
+	struct aivoice_evout_afe afe = { ch_num, frame, "{\"abnormal_flag\":0}" };
+	rtk_aivoice_event_queue_handler(queue, AIVOICE_EVOUT_AFE, &afe, sizeof(afe));
+}
+
+static void test_afe_copy(void)
+{
+	struct aivoice_event_queue_config config = AIVOICE_EVENT_QUEUE_CONFIG_DEFAULT();
+	config.audio_slots = 4;
+	config.audio_slot_bytes = 2 * CHANNEL_BYTES;
+	config.channel_bytes = CHANNEL_BYTES;
+	struct aivoice_event_queue *queue = rtk_aivoice_event_queue_create(&config);
+	struct aivoice_event_queue_stats stats;
+	struct aivoice_event events[4];
+
+	for (int i = 0; i < 3 * FRAME_SAMPLES; i++) {
+		frame[i] = (short)i;
+	}
+
+	// one channel in a slot of two, only the channel is read
+	push_afe(queue, 1);
+	// two channels fill the slot
+	push_afe(queue, 2);
+	// three channels do not fit, two are kept
+	push_afe(queue, 3);
+
+	CHECK(rtk_aivoice_poll_events(queue, events, 4) == 3);
+	CHECK(events[0].u.afe.ch_num == 1);
+	CHECK(memcmp(events[0].u.afe.data, frame, CHANNEL_BYTES) == 0);
+	CHECK(events[1].u.afe.ch_num == 2);
+	CHECK(memcmp(events[1].u.afe.data, frame, 2 * CHANNEL_BYTES) == 0);
+	CHECK(events[2].u.afe.ch_num == 2);
+	CHECK(memcmp(events[2].u.afe.data, frame, 2 * CHANNEL_BYTES) == 0);
+
+	rtk_aivoice_event_queue_get_stats(queue, &stats);
+	CHECK(stats.pushed == 3);
+	CHECK(stats.dropped_audio == 1);
+
+	// slots are held until the next poll, then one frame finds no free slot
+	CHECK(rtk_aivoice_poll_events(queue, events, 4) == 0);
+	for (int i = 0; i < 5; i++) {
+		push_afe(queue, 1);
+	}
+	CHECK(rtk_aivoice_poll_events(queue, events, 4) == 4);
+	CHECK(rtk_aivoice_poll_events(queue, events, 4) == 1);
+	CHECK(events[0].u.afe.data == NULL);
+	rtk_aivoice_event_queue_get_stats(queue, &stats);
+	CHECK(stats.dropped_audio == 2);
+	rtk_aivoice_event_queue_destroy(queue);
+}
+
+static void test_one_channel_slots(void)
+{
+	// channel_bytes 0: a slot holds one channel, as before channel_bytes was added
+	struct aivoice_event_queue_config config = AIVOICE_EVENT_QUEUE_CONFIG_DEFAULT();
+	config.audio_slots = 2;
+	config.audio_slot_bytes = CHANNEL_BYTES;
+	config.channel_bytes = 0;
+	struct aivoice_event_queue *queue = rtk_aivoice_event_queue_create(&config);
+	struct aivoice_event_queue_stats stats;
+	struct aivoice_event events[2];
+
+	push_afe(queue, 1);
+	push_afe(queue, 2);
+	CHECK(rtk_aivoice_poll_events(queue, events, 2) == 2);
+	CHECK(events[0].u.afe.ch_num == 1 && events[1].u.afe.ch_num == 1);
+	CHECK(memcmp(events[1].u.afe.data, frame, CHANNEL_BYTES) == 0);
+	rtk_aivoice_event_queue_get_stats(queue, &stats);
+	CHECK(stats.dropped_audio == 1);
+	rtk_aivoice_event_queue_destroy(queue);
+
+	config.channel_bytes = -1;
+	CHECK(rtk_aivoice_event_queue_create(&config) == NULL);
+}
+
+int main(void)
+{
+	test_afe_copy();
+	test_one_channel_slots();
+	return TEST_RESULT();
+}
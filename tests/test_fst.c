@@ -0,0 +1,358 @@
+#include <string.h>
+
+#include "aivoice_fst.h"
+#include "test_common.h"
+
+#define NUM_UNITS       402     /* units of the asr_cn models */
+#define HEADER_LEN      32
+#define SECTION_LEN     16
+#define GRAPH_HEADER    16
+#define ARC_LEN         8
+#define SECTION_GRAPH   0x0f
+
+/* units of the asr_cn models used by fst_cn_cmd_ac40, the other units are not needed */
+static const struct {
+	int id;
+	const char *pinyin;
+} ac40_units[] = {
+	{6, "ba"}, {7, "bai"}, {14, "bi"}, {20, "bo"}, {41, "chu"}, {56, "da"}, {60, "dao"},
+	{63, "deng"}, {64, "di"}, {65, "dian"}, {70, "dong"}, {72, "du"}, {73, "duan"}, {80, "er"},
+	{83, "fang"}, {86, "feng"}, {94, "gao"}, {102, "gua"}, {104, "guan"}, {121, "hua"},
+	{129, "jia"}, {130, "jian"}, {133, "jie"}, {137, "jiu"}, {143, "kai"}, {150, "kong"},
+	{167, "leng"}, {171, "liang"}, {176, "liu"}, {201, "mo"}, {246, "qi"}, {263, "re"},
+	{276, "san"}, {285, "shang"}, {291, "shi"}, {301, "si"}, {302, "song"}, {304, "su"},
+	{318, "tiao"}, {320, "ting"}, {336, "wu"}, {338, "xia"}, {341, "xiao"}, {356, "yi"},
+	{357, "yin"}, {361, "you"}, {364, "yue"}, {368, "zan"}, {374, "zeng"}, {383, "zhi"},
+	{384, "zhong"}, {394, "zi"}, {399, "zui"}, {401, "zuo"},
+};
+
+/* the commands of fst_cn_cmd_ac40, in the order of their ids */
+static const struct aivoice_fst_command ac40_commands[] = {
+	{"da kai kong tiao", "打开空调"},
+	{"guan bi kong tiao", "关闭空调"},
+	{"zhi leng mo shi", "制冷模式"},
+	{"zhi re mo shi", "制热模式"},
+	{"jia re mo shi", "加热模式"},
+	{"song feng mo shi", "送风模式"},
+	{"chu shi mo shi", "除湿模式"},
+	{"tiao dao shi liu du", "调到十六度"},
+	{"tiao dao shi qi du", "调到十七度"},
+	{"tiao dao shi ba du", "调到十八度"},
+	{"tiao dao shi jiu du", "调到十九度"},
+	{"tiao dao er shi du", "调到二十度"},
+	{"tiao dao er shi yi du", "调到二十一度"},
+	{"tiao dao er shi er du", "调到二十二度"},
+	{"tiao dao er shi san du", "调到二十三度"},
+	{"tiao dao er shi si du", "调到二十四度"},
+	{"tiao dao er shi wu du", "调到二十五度"},
+	{"tiao dao er shi liu du", "调到二十六度"},
+	{"tiao dao er shi qi du", "调到二十七度"},
+	{"tiao dao er shi ba du", "调到二十八度"},
+	{"tiao dao er shi jiu du", "调到二十九度"},
+	{"tiao dao san shi du", "调到三十度"},
+	{"kai gao yi du", "开高一度"},
+	{"kai di yi du", "开低一度"},
+	{"gao su feng", "高速风"},
+	{"zhong su feng", "中速风"},
+	{"di su feng", "低速风"},
+	{"zeng da feng su", "增大风速"},
+	{"jian xiao feng su", "减小风速"},
+	{"zi dong feng", "自动风"},
+	{"zui da feng liang", "最大风量"},
+	{"zhong deng feng liang", "中等风量"},
+	{"zui xiao feng liang", "最小风量"},
+	{"zi dong feng liang", "自动风量"},
+	{"zuo you bai feng", "左右摆风"},
+	{"shang xia bai feng", "上下摆风"},
+	{"bo fang yin yue", "播放音乐"},
+	{"zan ting bo fang", "暂停播放"},
+	{"jie ting dian hua", "接听电话"},
+	{"gua duan dian hua", "挂断电话"},
+};
+
+#define AC40_NUM    (int)(sizeof(ac40_commands) / sizeof(ac40_commands[0]))
+
+static const char *units[NUM_UNITS];
+
+struct arc {
+	unsigned int src;
+	unsigned int dst;
+	unsigned int unit;
+	unsigned int command;
+};
+
+static unsigned int le16(const unsigned char *p)
+{
+	return (unsigned int)p[0] | ((unsigned int)p[1] << 8);
+}
+
+static unsigned int le32(const unsigned char *p)
+{
+	return le16(p) | (le16(p + 2) << 16);
+}
+
+/* graph section data of an FST, NULL when missing */
+static const unsigned char *find_graph(const unsigned char *fst, unsigned int *offset)
+{
+	unsigned int size = le32(fst + 16);
+	unsigned int sections = le32(fst + 24);
+	unsigned int pos = HEADER_LEN;
+
+	for (unsigned int i = 0; i < sections && pos + SECTION_LEN <= size; i++) {
+		if (le32(fst + pos) == SECTION_GRAPH) {
+			*offset = pos;
+			return fst + pos + SECTION_LEN;
+		}
+		pos = (pos + SECTION_LEN + le32(fst + pos + 4) + 15) & ~15u;
+	}
+	return NULL;
+}
+
+/* arcs of state in graph, in unit order (units of a state are unique) */
+static int state_arcs(const unsigned char *graph, unsigned int state, struct arc *arcs, int max)
+{
+	int num_arcs = (int)le16(graph + 4);
+	const unsigned char *p = graph + GRAPH_HEADER;
+	int n = 0;
+
+	for (int i = 0; i < num_arcs; i++, p += ARC_LEN) {
+		if (le16(p) != state || n == max) {
+			continue;
+		}
+		struct arc arc = { le16(p), le16(p + 2), le16(p + 4), le16(p + 6) };
+		int k = n++;
+		for (; k > 0 && arcs[k - 1].unit > arc.unit; k--) {
+			arcs[k] = arcs[k - 1];
+		}
+		arcs[k] = arc;
+	}
+	return n;
+}
+
+/*
+ * Graphs are the same up to the numbering of states: walking both from the
+ * start state, every state pair has the same units and commands on its arcs
+ * and leads to consistently paired states, and the final states are paired.
+ */
+static int same_graph(const unsigned char *a, const unsigned char *b)
+{
+	int num_states = (int)le16(a + 2);
+	if (num_states != (int)le16(b + 2) || le16(a + 4) != le16(b + 4)) {
+		return 0;
+	}
+
+	int *pair = (int *)malloc((size_t)num_states * sizeof(int));
+	int *paired = (int *)malloc((size_t)num_states * sizeof(int));
+	int *queue = (int *)malloc((size_t)num_states * sizeof(int));
+	struct arc arcs_a[NUM_UNITS];
+	struct arc arcs_b[NUM_UNITS];
+	int head = 0;
+	int tail = 0;
+	int same = 1;
+
+	for (int i = 0; i < num_states; i++) {
+		pair[i] = -1;
+		paired[i] = 0;
+	}
+	pair[le16(a + 8)] = (int)le16(b + 8);
+	paired[le16(b + 8)] = 1;
+	queue[tail++] = (int)le16(a + 8);
+
+	while (same && head < tail) {
+		int state = queue[head++];
+		int n = state_arcs(a, (unsigned int)state, arcs_a, NUM_UNITS);
+		if (n != state_arcs(b, (unsigned int)pair[state], arcs_b, NUM_UNITS)) {
+			same = 0;
+			break;
+		}
+		for (int i = 0; i < n && same; i++) {
+			int dst = (int)arcs_a[i].dst;
+			if (arcs_a[i].unit != arcs_b[i].unit || arcs_a[i].command != arcs_b[i].command ||
+				dst >= num_states || (int)arcs_b[i].dst >= num_states) {
+				same = 0;
+			} else if (pair[dst] < 0) {
+				if (paired[arcs_b[i].dst]) {
+					same = 0;
+				} else {
+					pair[dst] = (int)arcs_b[i].dst;
+					paired[arcs_b[i].dst] = 1;
+					queue[tail++] = dst;
+				}
+			} else if (pair[dst] != (int)arcs_b[i].dst) {
+				same = 0;
+			}
+		}
+	}
+	same = same && tail == num_states && pair[le16(a + 10)] == (int)le16(b + 10);
+
+	free(pair);
+	free(paired);
+	free(queue);
+	return same;
+}
+
+/*
+ * Follow the units of pinyin from the start state, then the end unit when the
+ * state is not final. Returns the command output on the way, -1 when the path
+ * does not reach the final state or outputs more than one command.
+ */
+static int walk(const unsigned char *graph, const char *pinyin)
+{
+	int num_arcs = (int)le16(graph + 4);
+	unsigned int state = le16(graph + 8);
+	unsigned int final = le16(graph + 10);
+	int command = 0;
+	char unit[16];
+	int n;
+
+	for (;;) {
+		int id = 0;
+		if (sscanf(pinyin, "%15s%n", unit, &n) == 1) {
+			pinyin += n;
+			for (id = 1; id < NUM_UNITS && (!units[id] || strcmp(units[id], unit) != 0); id++);
+		} else if (state == final) {
+			return command ? command : -1;
+		}
+
+		const unsigned char *p = graph + GRAPH_HEADER;
+		int i;
+		for (i = 0; i < num_arcs; i++, p += ARC_LEN) {
+			if (le16(p) == state && (int)le16(p + 4) == id) {
+				break;
+			}
+		}
+		if (i == num_arcs) {
+			return -1;
+		}
+		if (le16(p + 6)) {
+			if (command) {
+				return -1;
+			}
+			command = (int)le16(p + 6);
+		}
+		state = le16(p + 2);
+		if (id == 0) {
+			return state == final ? command : -1;
+		}
+	}
+}
+
+static unsigned char *compile(const struct aivoice_fst_command *commands, int num, int *size)
+{
+	*size = rtk_aivoice_fst_compile(commands, num, units, NUM_UNITS, NULL, 0);
+	CHECK(*size > 0);
+	if (*size <= 0) {
+		return NULL;
+	}
+	unsigned char *fst = (unsigned char *)malloc((size_t)*size);
+	CHECK(rtk_aivoice_fst_compile(commands, num, units, NUM_UNITS, fst, (unsigned int)*size - 1) == -1);
+	CHECK(rtk_aivoice_fst_compile(commands, num, units, NUM_UNITS, fst, (unsigned int)*size) == *size);
+	return fst;
+}
+
+/* compiled ac40 commands match the prebuilt FST */
+static void test_ac40(const char *bins_dir)
+{
+	unsigned int prebuilt_size;
+	unsigned char *prebuilt = read_file(bins_dir, "fst_cn_cmd_ac40.bin", &prebuilt_size);
+	int size;
+	unsigned char *fst = compile(ac40_commands, AC40_NUM, &size);
+	CHECK(prebuilt && fst);
+	if (!prebuilt || !fst) {
+		free(prebuilt);
+		free(fst);
+		return;
+	}
+
+	struct aivoice_fst_info info;
+	struct aivoice_fst_info prebuilt_info;
+	CHECK(rtk_aivoice_fst_get_info(fst, &info) == 0);
+	CHECK(rtk_aivoice_fst_get_info(prebuilt, &prebuilt_info) == 0);
+	CHECK(memcmp(&info, &prebuilt_info, sizeof(info)) == 0);
+	CHECK(info.num_commands == AC40_NUM && info.num_units == NUM_UNITS);
+	CHECK((unsigned int)size == prebuilt_size);
+
+	// header and symbols are the same bytes. The graph is the same up to the numbering of
+	// states: the prebuilt one does not keep unit order in the arcs of one state, which
+	// numbers the states after it differently
+	unsigned int graph_offset;
+	unsigned int prebuilt_graph_offset;
+	const unsigned char *graph = find_graph(fst, &graph_offset);
+	const unsigned char *prebuilt_graph = find_graph(prebuilt, &prebuilt_graph_offset);
+	CHECK(graph && prebuilt_graph);
+	if (graph && prebuilt_graph) {
+		CHECK(graph_offset == prebuilt_graph_offset);
+		CHECK(memcmp(fst, prebuilt, graph_offset) == 0);
+		CHECK(memcmp(graph, prebuilt_graph, GRAPH_HEADER) == 0);
+		CHECK(same_graph(graph, prebuilt_graph));
+
+		for (int i = 0; i < AC40_NUM; i++) {
+			CHECK(walk(graph, ac40_commands[i].pinyin) == i + 1);
+			CHECK(walk(prebuilt_graph, ac40_commands[i].pinyin) == i + 1);
+		}
+	}
+
+	// trailer
+	CHECK((unsigned int)size == prebuilt_size && memcmp(fst + size - 16, prebuilt + size - 16, 16) == 0);
+	free(fst);
+	free(prebuilt);
+}
+
+static void test_prefix_command(void)
+{
+	static const struct aivoice_fst_command commands[] = {
+		{"da kai kong tiao", "打开空调"},
+		{"da kai", "打开"},
+		{"guan bi kong tiao", "关闭空调"},
+	};
+	int size;
+	unsigned char *fst = compile(commands, 3, &size);
+	unsigned int offset;
+	const unsigned char *graph = fst ? find_graph(fst, &offset) : NULL;
+	CHECK(graph != NULL);
+	if (!graph) {
+		free(fst);
+		return;
+	}
+
+	CHECK(walk(graph, "da kai kong tiao") == 1);
+	CHECK(walk(graph, "da kai") == 2);
+	CHECK(walk(graph, "guan bi kong tiao") == 3);
+	CHECK(walk(graph, "da") == -1);
+	CHECK(walk(graph, "guan bi") == -1);
+
+	// "da kai" ends with the only arc of unit 0, into the final state
+	int num = (int)le16(graph + 4);
+	int end_arcs = 0;
+	const unsigned char *p = graph + GRAPH_HEADER;
+	for (int i = 0; i < num; i++, p += ARC_LEN) {
+		if (le16(p + 4) == 0) {
+			end_arcs++;
+			CHECK(le16(p + 2) == le16(graph + 10));
+			CHECK(le16(p + 6) == 2);
+		}
+	}
+	CHECK(end_arcs == 1);
+	free(fst);
+
+	// same pinyin twice, and an unknown unit
+	static const struct aivoice_fst_command same[] = { {"da kai", "a"}, {"da-kai", "b"} };
+	static const struct aivoice_fst_command unknown[] = { {"da kai xyz", "a"} };
+	CHECK(rtk_aivoice_fst_compile(same, 2, units, NUM_UNITS, NULL, 0) == -1);
+	CHECK(rtk_aivoice_fst_compile(unknown, 1, units, NUM_UNITS, NULL, 0) == -1);
+}
+
+int main(int argc, char *argv[])
+{
+	if (argc < 2) {
+		printf("usage: %s <prebuilt bins dir>\n", argv[0]);
+		return 1;
+	}
+
+	for (unsigned int i = 0; i < sizeof(ac40_units) / sizeof(ac40_units[0]); i++) {
+		units[ac40_units[i].id] = ac40_units[i].pinyin;
+	}
+	test_ac40(argv[1]);
+	test_prefix_command();
+	return TEST_RESULT();
+}
@@ -0,0 +1,128 @@
+#include <pthread.h>
+#include <string.h>
+
+#include "aivoice_lookback.h"
+#include "test_common.h"
+
+#define RING_MS         32      /* 512 samples, overwritten often */
+#define RING_SAMPLES    (RING_MS * 16)
+#define PUSH_SAMPLES    100
+#define PUSH_ROUNDS     200000
+
+static volatile int writer_done;
+
+static short sample_at(unsigned long long pos)
+{
+	return (short)(pos & 0x7FFF);
+}
+
+static void *writer_thread(void *arg)
+{
+	struct aivoice_lookback *lookback = (struct aivoice_lookback *)arg;
+	short chunk[PUSH_SAMPLES];
+	unsigned long long pos = 0;
+
+	for (int round = 0; round < PUSH_ROUNDS; round++) {
+		for (int i = 0; i < PUSH_SAMPLES; i++) {
+			chunk[i] = sample_at(pos++);
+		}
+		rtk_aivoice_lookback_push(lookback, chunk, PUSH_SAMPLES);
+	}
+	__sync_synchronize();
+	writer_done = 1;
+	return NULL;
+}
+
+static void test_concurrent_reader(void)
+{
+	struct aivoice_lookback_config config = AIVOICE_LOOKBACK_CONFIG_DEFAULT();
+	config.duration_ms = RING_MS;
+	struct aivoice_lookback *lookback = rtk_aivoice_lookback_create(&config);
+	CHECK(lookback != NULL);
+	if (!lookback) {
+		return;
+	}
+
+	pthread_t writer;
+	pthread_create(&writer, NULL, writer_thread, lookback);
+
+	short copy[RING_SAMPLES];
+	int valid = 0;
+	int corrupted = 0;
+	while (!writer_done) {
+		struct aivoice_audio_segment segment;
+		if (rtk_aivoice_lookback_get(lookback, 0, 0xFFFFFFFFu / 16, &segment) != 0) {
+			continue;
+		}
+
+		int total = segment.samples[0] + segment.samples[1];
+		memcpy(copy, segment.data[0], segment.samples[0] * sizeof(short));
+		if (segment.samples[1]) {
+			memcpy(copy + segment.samples[0], segment.data[1], segment.samples[1] * sizeof(short));
+		}
+		__sync_synchronize();
+		if (!rtk_aivoice_lookback_segment_valid(lookback, &segment)) {
+			continue;
+		}
+
+		valid++;
+		for (int i = 0; i < total; i++) {
+			if (copy[i] != sample_at(segment.start_sample + i)) {
+				corrupted++;
+				break;
+			}
+		}
+	}
+	pthread_join(writer, NULL);
+
+	printf("valid segments %d, corrupted %d\n", valid, corrupted);
+	CHECK(valid > 0);
+	CHECK(corrupted == 0);
+	rtk_aivoice_lookback_destroy(lookback);
+}
+
+static void test_wrap_and_clip(void)
+{
+	struct aivoice_lookback_config config = AIVOICE_LOOKBACK_CONFIG_DEFAULT();
+	config.duration_ms = RING_MS;
+	struct aivoice_lookback *lookback = rtk_aivoice_lookback_create(&config);
+	struct aivoice_audio_segment segment;
+	short chunk[RING_SAMPLES];
+
+	for (int i = 0; i < RING_SAMPLES; i++) {
+		chunk[i] = sample_at(i);
+	}
+	CHECK(rtk_aivoice_lookback_get(lookback, 0, 10, &segment) != 0);
+
+	rtk_aivoice_lookback_push(lookback, chunk, 320);           /* 20 ms */
+	CHECK(rtk_aivoice_lookback_get(lookback, 5, 100, &segment) == 0);
+	CHECK(segment.start_sample == 80);
+	CHECK(segment.samples[0] == 240 && segment.samples[1] == 0);
+	CHECK(segment.data[0][0] == sample_at(80));
+
+	for (int i = 0; i < RING_SAMPLES; i++) {
+		chunk[i] = sample_at(320 + i);
+	}
+	rtk_aivoice_lookback_push(lookback, chunk, 320);           /* 40 ms, ring holds [8, 40) ms */
+	CHECK(rtk_aivoice_lookback_get(lookback, 0, 40, &segment) == 0);
+	CHECK(segment.start_sample == 128);
+	CHECK(segment.samples[0] + segment.samples[1] == RING_SAMPLES);
+	CHECK(segment.data[1] != NULL);
+	CHECK(segment.data[0][0] == sample_at(128));
+	CHECK(segment.data[1][0] == sample_at(128 + segment.samples[0]));
+	CHECK(rtk_aivoice_lookback_segment_valid(lookback, &segment));
+
+	rtk_aivoice_lookback_push(lookback, chunk, 1);
+	CHECK(!rtk_aivoice_lookback_segment_valid(lookback, &segment));
+
+	rtk_aivoice_lookback_reset(lookback);
+	CHECK(rtk_aivoice_lookback_get(lookback, 0, 40, &segment) != 0);
+	rtk_aivoice_lookback_destroy(lookback);
+}
+
+int main(void)
+{
+	test_wrap_and_clip();
+	test_concurrent_reader();
+	return TEST_RESULT();
+}
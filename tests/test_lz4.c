@@ -0,0 +1,88 @@
+#include <string.h>
+
+#include "aivoice_lz4.h"
+#include "test_common.h"
+
+static const char *cases[] = { "empty", "short", "run", "runs", "random", "text" };
+
+static void test_case(const char *dir, const char *name)
+{
+	char file[64];
+	unsigned int raw_len;
+	unsigned int lz4_len;
+
+	snprintf(file, sizeof(file), "lz4_%s.raw", name);
+	unsigned char *raw = read_file(dir, file, &raw_len);
+	snprintf(file, sizeof(file), "lz4_%s.lz4", name);
+	unsigned char *lz4 = read_file(dir, file, &lz4_len);
+	CHECK(raw && lz4);
+	if (!raw || !lz4) {
+		free(raw);
+		free(lz4);
+		return;
+	}
+
+	// one spare byte to catch writes past dst_len
+	unsigned char *out = (unsigned char *)malloc(raw_len + 1);
+	out[raw_len] = 0xA5;
+	CHECK(aivoice_lz4_decode(lz4, lz4_len, out, raw_len) == 0);
+	CHECK(memcmp(out, raw, raw_len) == 0);
+	CHECK(out[raw_len] == 0xA5);
+
+	// output size must match exactly
+	CHECK(aivoice_lz4_decode(lz4, lz4_len, out, raw_len + 1) == -1);
+	if (raw_len > 0) {
+		CHECK(aivoice_lz4_decode(lz4, lz4_len, out, raw_len - 1) == -1);
+	}
+
+	// truncated input
+	for (unsigned int len = raw_len ? 0 : 1; len < lz4_len; len++) {
+		if (aivoice_lz4_decode(lz4, len, out, raw_len) != -1) {
+			printf("%s: truncated to %u bytes decoded\n", name, len);
+			CHECK(0);
+			break;
+		}
+	}
+
+	// overlong input
+	unsigned char *longer = (unsigned char *)malloc(lz4_len + 2);
+	memcpy(longer, lz4, lz4_len);
+	longer[lz4_len] = 0x00;
+	longer[lz4_len + 1] = 0x00;
+	CHECK(aivoice_lz4_decode(longer, lz4_len + 1, out, raw_len) == -1);
+	CHECK(aivoice_lz4_decode(longer, lz4_len + 2, out, raw_len) == -1);
+
+	free(longer);
+	free(out);
+	free(raw);
+	free(lz4);
+}
+
+static void test_bad_offset(void)
+{
+	unsigned char out[16];
+
+	// 4 literals then a match at offset 0, and at offset 5 before the start
+	static const unsigned char zero_offset[] = { 0x40, 'a', 'b', 'c', 'd', 0x00, 0x00, 0x10, 'e' };
+	static const unsigned char far_offset[] = { 0x40, 'a', 'b', 'c', 'd', 0x05, 0x00, 0x10, 'e' };
+	static const unsigned char good_offset[] = { 0x40, 'a', 'b', 'c', 'd', 0x04, 0x00, 0x10, 'e' };
+
+	CHECK(aivoice_lz4_decode(zero_offset, sizeof(zero_offset), out, 9) == -1);
+	CHECK(aivoice_lz4_decode(far_offset, sizeof(far_offset), out, 9) == -1);
+	CHECK(aivoice_lz4_decode(good_offset, sizeof(good_offset), out, 9) == 0);
+	CHECK(memcmp(out, "abcdabcde", 9) == 0);
+}
+
+int main(int argc, char *argv[])
+{
+	if (argc < 2) {
+		printf("usage: %s <vectors dir>\n", argv[0]);
+		return 1;
+	}
+
+	for (unsigned int i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+		test_case(argv[1], cases[i]);
+	}
+	test_bad_offset();
+	return TEST_RESULT();
+}
@@ -0,0 +1,39 @@
+#include "aivoice_memory.h"
+#include "aivoice_afe_config.h"
+#include "aivoice_utils.h"
+#include "test_common.h"
+
+extern int aivoice_stub_feed_bytes[2];
+
+int main(void)
+{
+	struct afe_config afe = AFE_CONFIG_ASR_DEFAULT_2MIC50MM();
+	struct aivoice_config config = { 0 };
+	struct aivoice_memory_report report;
+	int afe_bytes = (2 + afe.ref_num) * afe.frame_size * (int)sizeof(short);
+
+	// single module flows without AFE take mono frames and need no afe config
+	const struct rtk_aivoice_iface *mono_flows[] = { &aivoice_iface_vad_v1, &aivoice_iface_kws_v1, &aivoice_iface_asr_v1 };
+	for (int i = 0; i < 3; i++) {
+		aivoice_stub_feed_bytes[0] = 0;
+		CHECK(rtk_aivoice_query_memory(mono_flows[i], &config, &report) == 0);
+		CHECK(aivoice_stub_feed_bytes[0] == AIVOICE_MONO_FRAME_BYTES);
+		CHECK(report.module_mask == (unsigned int)(1 << (AIVOICE_MEMORY_MODULE_VAD + i)));
+	}
+
+	// flows with AFE need it
+	CHECK(rtk_aivoice_query_memory(&aivoice_iface_afe_v1, &config, &report) != 0);
+	CHECK(rtk_aivoice_query_memory(&aivoice_iface_full_flow_v1, &config, &report) != 0);
+
+	config.afe = &afe;
+	aivoice_stub_feed_bytes[0] = 0;
+	aivoice_stub_feed_bytes[1] = 0;
+	CHECK(rtk_aivoice_query_memory(&aivoice_iface_full_flow_v1, &config, &report) == 0);
+	CHECK(aivoice_stub_feed_bytes[1] == afe_bytes);
+	CHECK(aivoice_stub_feed_bytes[0] == AIVOICE_MONO_FRAME_BYTES);
+	CHECK(report.module_mask == ((1 << AIVOICE_MEMORY_MODULE_AFE) | (1 << AIVOICE_MEMORY_MODULE_VAD) |
+								 (1 << AIVOICE_MEMORY_MODULE_KWS) | (1 << AIVOICE_MEMORY_MODULE_ASR)));
+
+	CHECK(rtk_aivoice_query_memory(&aivoice_iface_vad_v1, NULL, &report) != 0);
+	return TEST_RESULT();
+}
@@ -0,0 +1,88 @@
+#include <string.h>
+
+#include "aivoice_resource.h"
+#include "test_common.h"
+
+static const char *vad_names[] = { "vad_v11_208K", "vad_v7_200K", "vad_v8_60K", "vad_v9_208K" };
+#define VAD_NUM     (int)(sizeof(vad_names) / sizeof(vad_names[0]))
+
+/* model data in a loaded resource must be the bin it was packed from */
+static void check_model(const char *bins_dir, const char *data, const struct aivoice_model_entry *entry)
+{
+	char file[64];
+	unsigned int size;
+
+	snprintf(file, sizeof(file), "%s.bin", entry->name);
+	unsigned char *bin = read_file(bins_dir, file, &size);
+	CHECK(bin != NULL);
+	if (!bin) {
+		return;
+	}
+	CHECK(entry->type == AIVOICE_MODEL_VAD);
+	CHECK(entry->size == size);
+	CHECK(!entry->compressed && !entry->chunked);
+	CHECK(entry->size == size && memcmp(data + entry->offset, bin, size) == 0);
+	free(bin);
+}
+
+static void test_bundle(const char *vectors_dir, const char *bins_dir, const char *bundle, int dedup)
+{
+	unsigned int size;
+	unsigned char *file = read_file(vectors_dir, bundle, &size);
+	CHECK(file != NULL);
+	if (!file) {
+		return;
+	}
+
+	struct aivoice_model_entry entries[8];
+	CHECK(rtk_aivoice_resource_list(file, entries, 8) == VAD_NUM);
+	int chunked = 0;
+	for (int i = 0; i < VAD_NUM; i++) {
+		chunked += entries[i].chunked;
+	}
+	CHECK(dedup ? chunked > 0 : chunked == 0);
+
+	// every variant
+	struct aivoice_resource *res = rtk_aivoice_resource_open(file, 0);
+	CHECK(res != NULL);
+	if (res) {
+		const char *data = rtk_aivoice_resource_data(res);
+		CHECK(rtk_aivoice_resource_list(data, entries, 8) == VAD_NUM);
+		for (int i = 0; i < VAD_NUM; i++) {
+			CHECK(strcmp(entries[i].name, vad_names[i]) == 0);
+			check_model(bins_dir, data, &entries[i]);
+		}
+		rtk_aivoice_resource_close(res);
+	}
+
+	// one variant by name
+	for (int i = 0; i < VAD_NUM; i++) {
+		res = rtk_aivoice_resource_open_names(file, &vad_names[i], 1);
+		CHECK(res != NULL);
+		if (!res) {
+			continue;
+		}
+		const char *data = rtk_aivoice_resource_data(res);
+		CHECK(rtk_aivoice_resource_find(data, AIVOICE_MODEL_VAD, NULL, &entries[0]) == 0);
+		CHECK(strcmp(entries[0].name, vad_names[i]) == 0);
+		check_model(bins_dir, data, &entries[0]);
+		CHECK(rtk_aivoice_resource_list(data, NULL, 0) == 1);
+		rtk_aivoice_resource_close(res);
+	}
+
+	const char *missing = "vad_v1";
+	CHECK(rtk_aivoice_resource_open_names(file, &missing, 1) == NULL);
+	free(file);
+}
+
+int main(int argc, char *argv[])
+{
+	if (argc < 3) {
+		printf("usage: %s <vectors dir> <prebuilt bins dir>\n", argv[0]);
+		return 1;
+	}
+
+	test_bundle(argv[1], argv[2], "vad_variants.bin", 0);
+	test_bundle(argv[1], argv[2], "vad_variants_dedup.bin", 1);
+	return TEST_RESULT();
+}
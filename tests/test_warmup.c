@@ -0,0 +1,69 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "aivoice_warmup.h"
+#include "test_common.h"
+
+#define FRAME_BYTES     (256 * 2 * 3)   /* 2 mic + 1 ref */
+
+static int events;
+
+static int count_callback(void *user_data, enum aivoice_out_event_type event_type,
+						  const void *msg, int len)
+{
+	(void)user_data;
+	(void)event_type;
+	(void)msg;
+	(void)len;
+	events++;
+	return 0;
+}
+
+int main(void)
+{
+	struct aivoice_warmup_recorder *rec = rtk_aivoice_warmup_recorder_create(FRAME_BYTES, 160);
+	char frame[FRAME_BYTES];
+	int len = 0;
+
+	CHECK(rec != NULL);
+	CHECK(rtk_aivoice_warmup_recorder_push(rec, frame, FRAME_BYTES - 1) == -1);
+	for (int i = 0; i < 15; i++) {
+		memset(frame, i, sizeof(frame));
+		CHECK(rtk_aivoice_warmup_recorder_push(rec, frame, FRAME_BYTES) == 0);
+	}
+
+	// 160 ms keeps the last 10 frames
+	CHECK(rtk_aivoice_warmup_save(rec, NULL, &len) == 0);
+	CHECK(len == AIVOICE_WARMUP_HEADER_LEN + 10 * FRAME_BYTES);
+	char *blob = (char *)malloc(len);
+	int small = len - 1;
+	CHECK(rtk_aivoice_warmup_save(rec, blob, &small) == -1);
+	CHECK(rtk_aivoice_warmup_save(rec, blob, &len) == 0);
+	CHECK(blob[AIVOICE_WARMUP_HEADER_LEN] == 5);
+
+	void *afe = aivoice_iface_afe_v1.create(NULL);
+	CHECK(rtk_aivoice_warmup_replay(&aivoice_iface_afe_v1, afe, FRAME_BYTES, blob, len,
+									count_callback, NULL) == 0);
+	CHECK(events == 0);
+	aivoice_iface_afe_v1.feed(afe, frame, FRAME_BYTES);
+	CHECK(events == 1);
+
+	// recognition flows would detect what was said in the replayed audio
+	void *kws = aivoice_iface_afe_kws_v1.create(NULL);
+	CHECK(rtk_aivoice_warmup_replay(&aivoice_iface_afe_kws_v1, kws, FRAME_BYTES, blob, len,
+									count_callback, NULL) == -1);
+	aivoice_iface_afe_kws_v1.destroy(kws);
+
+	CHECK(rtk_aivoice_warmup_replay(&aivoice_iface_afe_v1, afe, FRAME_BYTES / 3 * 4, blob, len,
+									count_callback, NULL) == -1);
+	CHECK(rtk_aivoice_warmup_replay(&aivoice_iface_afe_v1, afe, FRAME_BYTES, blob, len - 1,
+									count_callback, NULL) == -1);
+	blob[0] = 'X';
+	CHECK(rtk_aivoice_warmup_replay(&aivoice_iface_afe_v1, afe, FRAME_BYTES, blob, len,
+									count_callback, NULL) == -1);
+
+	aivoice_iface_afe_v1.destroy(afe);
+	free(blob);
+	rtk_aivoice_warmup_recorder_destroy(rec);
+	return TEST_RESULT();
+}
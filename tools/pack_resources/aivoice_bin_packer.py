@@ -14,6 +14,11 @@ python aivoice_bin_packer.py \
     --no-config \
     --bins_dir <path_to_your_directory_need_to_packaged> \
     --out_dir <output_directory>
+
+add --lz4 to compress the models, see pack_models for the format.
+a crc32c digest of every model is added, unless --no-crc.
+add --variants to bundle several models of a type, e.g. for runtime switching,
+and --dedup to store the chunks they share once.
 '''
 
 import os
@@ -33,8 +38,22 @@ MODEL_TYPES = {
 
 MAGIC = b'RTAIBIN\x00'
 FILE_VERSION = 1
+FILE_VERSION_ENCODED = 2        # has lz4 or chunked models, version 1 loaders must not read them
 FILE_ALIGNMENT = 1024
 
+FLAG_LZ4 = 0x80000000           # in type of the model header
+FLAG_CHUNKED = 0x40000000
+DEDUP_CHUNK_SIZE = 256
+
+DIGEST_TAG = b'CRCS'            # digest table after the model headers
+CRC32C_POLY = 0x82f63b78        # reflected 0x1edc6f41
+
+# lz4 block format
+LZ4_MIN_MATCH = 4
+LZ4_LAST_LITERALS = 5           # the last 5 bytes are always literals
+LZ4_MF_LIMIT = 12               # the last match starts at least 12 bytes before the end
+LZ4_MAX_OFFSET = 65535
+
 def parse_args():
     parser = argparse.ArgumentParser(
             description='Realtek AIVoice Model Packer Tool:'
@@ -51,9 +70,26 @@ def parse_args():
                         help='Output directory (default: same as bins_dir)')
     parser.add_argument('--out_name', default='aivoice_models.bin',
                         help='Output binary name (default: aivoice_models.bin)')
+    parser.add_argument('--lz4', action='store_true',
+                        help='Compress models with lz4, decoded by rtk_aivoice_resource_open')
+    parser.add_argument('--no-crc', action='store_true',
+                        help='Do not add crc32c digests of the models')
+    parser.add_argument('--variants', action='store_true',
+                        help='Pack every bin of a model type, instead of one bin per type.'
+                            ' Models are looked up by name cut to 31 chars, so bin names must'
+                            ' differ in their first 31 chars')
+    parser.add_argument('--dedup', action='store_true',
+                        help='Store chunks shared by models once, rebuilt by rtk_aivoice_resource_open')
+    parser.add_argument('--chunk_size', type=int, default=DEDUP_CHUNK_SIZE,
+                        help='Dedup chunk size in bytes (default: {})'.format(DEDUP_CHUNK_SIZE))
 
     args = parser.parse_args()
 
+    if args.dedup and args.lz4:
+        parser.error('--dedup and --lz4 can not be combined, chunks are shared uncompressed')
+    if args.chunk_size < 16 or args.chunk_size % 16 != 0:
+        parser.error('--chunk_size must be a multiple of 16')
+
     args.bins_dir = os.path.abspath(args.bins_dir)
     args.out_dir  = os.path.abspath(args.out_dir) if args.out_dir else args.bins_dir
 
@@ -155,11 +191,119 @@ def scan_bins_directory_without_config(bins_dir):
 
     return matched
 
-def pack_models(matched_bins, bins_dir, out_path):
+def lz4_length(out, n):
+    while n >= 255:
+        out.append(255)
+        n -= 255
+    out.append(n)
+
+def lz4_sequence(out, literals, offset, match_len):
+    lit_len = len(literals)
+    token = min(lit_len, 15) << 4
+    if offset:
+        token |= min(match_len - LZ4_MIN_MATCH, 15)
+    out.append(token)
+    if lit_len >= 15:
+        lz4_length(out, lit_len - 15)
+    out += literals
+    if offset:
+        out += struct.pack('<H', offset)
+        if match_len - LZ4_MIN_MATCH >= 15:
+            lz4_length(out, match_len - LZ4_MIN_MATCH - 15)
+
+def lz4_compress_block(src):
+    out = bytearray()
+    n = len(src)
+    anchor = 0
+    pos = 0
+    last_pos = {}
+
+    while pos < n - LZ4_MF_LIMIT:
+        key = src[pos:pos + LZ4_MIN_MATCH]
+        ref = last_pos.get(key)
+        last_pos[key] = pos
+        if ref is None or pos - ref > LZ4_MAX_OFFSET:
+            pos += 1
+            continue
+
+        match_len = LZ4_MIN_MATCH
+        max_len = n - LZ4_LAST_LITERALS - pos
+        while match_len < max_len and src[ref + match_len] == src[pos + match_len]:
+            match_len += 1
+        while pos > anchor and ref > 0 and src[pos - 1] == src[ref - 1]:
+            pos -= 1
+            ref -= 1
+            match_len += 1
+
+        lz4_sequence(out, src[anchor:pos], pos - ref, match_len)
+        pos += match_len
+        anchor = pos
+
+    lz4_sequence(out, src[anchor:], 0, 0)
+    return bytes(out)
+
+def crc32c_table():
+    table = []
+    for i in range(256):
+        crc = i
+        for _ in range(8):
+            crc = (crc >> 1) ^ (CRC32C_POLY if crc & 1 else 0)
+        table.append(crc)
+    return table
+
+def crc32c(data, table=crc32c_table()):
+    crc = 0xffffffff
+    for b in data:
+        crc = (crc >> 8) ^ table[(crc ^ b) & 0xff]
+    return crc ^ 0xffffffff
+
+def dedup_chunks(bin_data, offset, pool, chunk_size):
+    '''
+    chunked form of bin_data stored at offset, or None when sharing saves nothing.
+    pool maps the content of every chunk in the file to its offset, and is updated.
+    '''
+    count = (len(bin_data) + chunk_size - 1) // chunk_size
+    table_size = 12 + 4 * count
+    chunks = [bin_data[i * chunk_size:(i + 1) * chunk_size] for i in range(count)]
+
+    shared = 0
+    seen = set(pool)
+    for chunk in chunks:
+        if chunk in seen:
+            shared += len(chunk)
+        seen.add(chunk)
+    if shared <= table_size:
+        for i, chunk in enumerate(chunks):
+            pool.setdefault(chunk, offset + i * chunk_size)
+        return None
+
+    table = bytearray(struct.pack('<III', len(bin_data), chunk_size, count))
+    data = bytearray()
+    for chunk in chunks:
+        if chunk not in pool:
+            pool[chunk] = offset + table_size + len(data)
+            data += chunk
+        table += struct.pack('<I', pool[chunk])
+    return bytes(table + data)
+
+def pack_models(matched_bins, bins_dir, out_path, lz4=False, crc=True, variants=False,
+                dedup=False, chunk_size=DEDUP_CHUNK_SIZE):
+    '''
+    header: magic, version, total length, model count, then one model header per model:
+    type, size, offset, name[32]. header is padded to 1024 bytes, models follow.
+    with lz4, a model is stored compressed when it gets smaller: FLAG_LZ4 is set in its type,
+    and its data is the decoded size (u32) followed by one lz4 block.
+    with dedup, a model sharing chunks with earlier models is stored chunked: FLAG_CHUNKED is set
+    in its type, and its data is the model size, chunk size and chunk count (u32), the offset from
+    the file start of each chunk (u32), then the chunks not stored before.
+    with crc, DIGEST_TAG and the crc32c of the stored data of each model follow the model headers,
+    of the rebuilt model for chunked models.
+    loaders that do not know the digests see header padding.
+    '''
     models = []
     for model_type, bin_files in matched_bins.items():
-        if bin_files:
-            models.append((MODEL_TYPES[model_type], bin_files[0]))
+        for bin_file in sorted(bin_files) if variants else bin_files[:1]:
+            models.append((MODEL_TYPES[model_type], bin_file))
 
     if not models:
         print("ERROR: No valid models to package")
@@ -167,6 +311,13 @@ def pack_models(matched_bins, bins_dir, out_path):
 
     models.sort(key=lambda x: x[0])
 
+    # models are looked up by name, which is cut to 31 chars
+    names = [os.path.splitext(m[1])[0][:31] for m in models]
+    for name in set(names):
+        if names.count(name) > 1:
+            print("ERROR: bins named {}... can not be told apart, names are cut to 31 chars".format(name))
+            return False
+
     header = bytearray()
     header += MAGIC
     header += struct.pack('<I', FILE_VERSION)
@@ -175,8 +326,11 @@ def pack_models(matched_bins, bins_dir, out_path):
 
     model_headers = bytearray()
     model_contents = bytearray()
+    digests = bytearray(DIGEST_TAG)
 
     current_offset = FILE_ALIGNMENT
+    encoded = False
+    pool = {}
 
     for model_id, bin_file in models:
         bin_path = os.path.join(bins_dir, bin_file)
@@ -186,6 +340,23 @@ def pack_models(matched_bins, bins_dir, out_path):
         bin_name = os.path.splitext(bin_file)[0]
         bin_name_bytes = bin_name.encode('ascii')[:31].ljust(32, b'\x00')
 
+        digest = crc32c(bin_data) if crc else 0
+        if lz4:
+            packed = struct.pack('<I', len(bin_data)) + lz4_compress_block(bin_data)
+            print("  {}: {} -> {} bytes".format(bin_file, len(bin_data), len(packed)))
+            if len(packed) < len(bin_data):
+                bin_data = packed
+                model_id |= FLAG_LZ4
+                encoded = True
+                digest = crc32c(bin_data) if crc else 0
+        if dedup:
+            packed = dedup_chunks(bin_data, current_offset, pool, chunk_size)
+            if packed:
+                print("  {}: {} -> {} bytes".format(bin_file, len(bin_data), len(packed)))
+                bin_data = packed
+                model_id |= FLAG_CHUNKED
+                encoded = True
+
         model_headers += struct.pack('<I', model_id)
         model_headers += struct.pack('<I', len(bin_data))
         model_headers += struct.pack('<I', current_offset)
@@ -193,8 +364,15 @@ def pack_models(matched_bins, bins_dir, out_path):
 
         model_contents += bin_data
         current_offset += len(bin_data)
+        if crc:
+            digests += struct.pack('<I', digest)
+
+    if encoded:
+        header[8:12] = struct.pack('<I', FILE_VERSION_ENCODED)
 
     header += model_headers
+    if crc:
+        header += digests
     header_padding = FILE_ALIGNMENT - len(header)
     assert(header_padding >= 0), "header is larger than 1024 bytes"
     if header_padding > 0:
@@ -235,12 +413,13 @@ def main():
         print("ERROR: No valid models found to pack")
         exit(1)
 
-    if check_duplicate_models(matched_bins):
+    if not args.variants and check_duplicate_models(matched_bins):
         print("Please Check your configure.")
         exit(1)
 
     out_path = os.path.join(args.out_dir, args.out_name)
-    if not pack_models(matched_bins, args.bins_dir, out_path):
+    if not pack_models(matched_bins, args.bins_dir, out_path, args.lz4, not args.no_crc,
+                       args.variants, args.dedup, args.chunk_size):
         print("ERROR: pack aivoice model failed")
         exit(1)
 